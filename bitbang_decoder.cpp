@@ -0,0 +1,146 @@
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITBANG_DECODER_X86
+#endif
+
+#include "bitbang_decoder.h"
+
+// The pin commands are the characters '0' to '7': value = command - '0' = (tck << 2) | (tms << 1) | tdi.
+// A command is a pin command if value has no bits set outside of the lowest three.
+
+static void decode_scalar(const char* commands, bitbang_block_t& block)
+{
+    block.pins = 0;
+    block.tck = 0;
+    block.tms = 0;
+    block.tdi = 0;
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        uint8_t value = static_cast<uint8_t>(commands[i] - '0');
+        uint64_t pin = (value & 0xF8) ? 0 : 1;
+
+        block.pins |= pin << i;
+        block.tck |= (pin & (value >> 2)) << i;
+        block.tms |= (pin & (value >> 1)) << i;
+        block.tdi |= (pin & value) << i;
+    }
+}
+
+#ifdef BITBANG_DECODER_X86
+
+static void decode_sse2(const char* commands, bitbang_block_t& block)
+{
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i pin_bits = _mm_set1_epi8(static_cast<char>(0xF8));
+
+    block.pins = 0;
+    block.tck = 0;
+    block.tms = 0;
+    block.tdi = 0;
+
+    for (uint32_t i = 0; i < 64; i += 16)
+    {
+        __m128i value = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(commands + i)), zero);
+        __m128i pin = _mm_cmpeq_epi8(_mm_and_si128(value, pin_bits), _mm_setzero_si128());
+
+        // movemask collects the top bit of every byte. Shifting the 16 bit lanes moves the pin bit of
+        // each byte to the top of that byte, the bits crossing over from the low byte stay below it.
+        uint64_t pins = static_cast<uint16_t>(_mm_movemask_epi8(pin));
+        uint64_t tck = static_cast<uint16_t>(_mm_movemask_epi8(_mm_slli_epi16(value, 5)));
+        uint64_t tms = static_cast<uint16_t>(_mm_movemask_epi8(_mm_slli_epi16(value, 6)));
+        uint64_t tdi = static_cast<uint16_t>(_mm_movemask_epi8(_mm_slli_epi16(value, 7)));
+
+        block.pins |= pins << i;
+        block.tck |= (tck & pins) << i;
+        block.tms |= (tms & pins) << i;
+        block.tdi |= (tdi & pins) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static void decode_avx2(const char* commands, bitbang_block_t& block)
+{
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i pin_bits = _mm256_set1_epi8(static_cast<char>(0xF8));
+
+    block.pins = 0;
+    block.tck = 0;
+    block.tms = 0;
+    block.tdi = 0;
+
+    for (uint32_t i = 0; i < 64; i += 32)
+    {
+        __m256i value = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(commands + i)), zero);
+        __m256i pin = _mm256_cmpeq_epi8(_mm256_and_si256(value, pin_bits), _mm256_setzero_si256());
+
+        uint64_t pins = static_cast<uint32_t>(_mm256_movemask_epi8(pin));
+        uint64_t tck = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(value, 5)));
+        uint64_t tms = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(value, 6)));
+        uint64_t tdi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(value, 7)));
+
+        block.pins |= pins << i;
+        block.tck |= (tck & pins) << i;
+        block.tms |= (tms & pins) << i;
+        block.tdi |= (tdi & pins) << i;
+    }
+}
+
+#endif
+
+typedef void (*decode_function_t)(const char* commands, bitbang_block_t& block);
+
+struct decoder_t {
+    decode_function_t decode;
+    const char* name;
+};
+
+static decoder_t select_decoder()
+{
+#ifdef BITBANG_DECODER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return { decode_avx2, "avx2" };
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return { decode_sse2, "sse2" };
+    }
+#endif
+    return { decode_scalar, "scalar" };
+}
+
+static const decoder_t decoder = select_decoder();
+
+void bitbang_decode(const char* commands, size_t count, bitbang_block_t& block)
+{
+    if (count < 64)
+    {
+        // the vector code always reads 64 bytes. Pad with something that is not a pin command.
+        char padded[64];
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, commands, count);
+
+        decoder.decode(padded, block);
+
+        uint64_t valid = (1ULL << count) - 1;
+        block.pins &= valid;
+        block.tck &= valid;
+        block.tms &= valid;
+        block.tdi &= valid;
+        block.others = valid & ~block.pins;
+
+        return;
+    }
+
+    decoder.decode(commands, block);
+    block.others = ~block.pins;
+}
+
+const char* bitbang_decoder_name()
+{
+    return decoder.name;
+}
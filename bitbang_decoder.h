@@ -0,0 +1,35 @@
+#ifndef BITBANG_DECODER_H
+#define BITBANG_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Up to 64 consecutive remote bitbang commands, decoded into one bit per command and pin.
+//
+// Bit i of every mask belongs to command i of the block. The pin masks are only valid for
+// the commands marked in pins. All other commands (R, r, B, b, Q, ...) are marked in others,
+// the caller looks them up in the command stream itself.
+struct bitbang_block_t {
+
+    // commands '0' to '7'
+    uint64_t pins;
+
+    // every other command of the block
+    uint64_t others;
+
+    uint64_t tck;
+    uint64_t tms;
+    uint64_t tdi;
+
+};
+
+/// @brief Decodes up to 64 commands into bitplanes. Uses AVX2 or SSE2 if the CPU has it.
+/// @param commands the commands as sent by the client
+/// @param count amount of commands, at most 64
+/// @param block receives the bitplanes
+void bitbang_decode(const char* commands, size_t count, bitbang_block_t& block);
+
+/// @brief Name of the implementation bitbang_decode() uses on this CPU (avx2, sse2 or scalar).
+const char* bitbang_decoder_name();
+
+#endif
@@ -0,0 +1,1709 @@
+#include <inttypes.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "debug_module.h"
+
+const DebugModule::register_handler_table_t DebugModule::register_handlers = DebugModule::create_register_handlers();
+
+DebugModule::register_handler_table_t DebugModule::create_register_handlers()
+{
+    register_handler_table_t table;
+
+    for (uint32_t address = 0; address <= ABITS_MASK; address++)
+    {
+        table.handlers[address] = { &DebugModule::read_unknown, &DebugModule::write_unknown };
+    }
+
+    // 0x04 (Abstract Data 0 (data0))
+    // 0x05 (Abstract Data 1 (data1))
+    // ...
+    // 0x0f (Abstract Data 11 (data11))
+    for (uint32_t address = 0x04; address <= 0x0f; address++)
+    {
+        table.handlers[address] = { &DebugModule::read_data, &DebugModule::write_data };
+    }
+
+    table.handlers[0x10] = { &DebugModule::read_dmcontrol, &DebugModule::write_dmcontrol };
+    table.handlers[0x11] = { &DebugModule::read_dmstatus, &DebugModule::write_dmstatus };
+    table.handlers[0x12] = { &DebugModule::read_hartinfo, &DebugModule::write_hartinfo };
+
+    // 0x13 (Halt Summary 1 (haltsum1))
+    // 0x40 (Halt Summary 0 (haltsum0))
+    table.handlers[0x13] = { &DebugModule::read_haltsum, &DebugModule::write_haltsum };
+    table.handlers[0x40] = { &DebugModule::read_haltsum, &DebugModule::write_haltsum };
+
+    // 0x14 (Hart Array Window Select (hawindowsel))
+    // 0x15 (Hart Array Window (hawindow))
+    table.handlers[0x14] = { &DebugModule::read_hawindowsel, &DebugModule::write_hawindowsel };
+    table.handlers[0x15] = { &DebugModule::read_hawindow, &DebugModule::write_hawindow };
+    table.handlers[0x16] = { &DebugModule::read_abstractcs, &DebugModule::write_abstractcs };
+    table.handlers[0x17] = { &DebugModule::read_command, &DebugModule::write_command };
+    table.handlers[0x18] = { &DebugModule::read_abstractauto, &DebugModule::write_abstractauto };
+
+    for (uint32_t address = 0x20; address <= 0x2f; address++)
+    {
+        table.handlers[address] = { &DebugModule::read_progbuf, &DebugModule::write_progbuf };
+    }
+
+    table.handlers[0x38] = { &DebugModule::read_sbcs, &DebugModule::write_sbcs };
+    table.handlers[0x39] = { &DebugModule::read_sbaddress, &DebugModule::write_sbaddress };
+    table.handlers[0x3a] = { &DebugModule::read_sbaddress, &DebugModule::write_sbaddress };
+    table.handlers[0x3c] = { &DebugModule::read_sbdata, &DebugModule::write_sbdata };
+    table.handlers[0x3d] = { &DebugModule::read_sbdata, &DebugModule::write_sbdata };
+
+    return table;
+}
+
+DebugModule::DebugModule(cpu_t* cpu)
+{
+    add_hart(cpu);
+}
+
+void DebugModule::add_hart(cpu_t* cpu)
+{
+    if (harts.size() == MAX_HART_COUNT)
+    {
+        fprintf(stderr, "[Error] the DM supports at most %" PRIu32 " harts\n", MAX_HART_COUNT);
+        abort();
+    }
+
+    hart_t new_hart;
+    new_hart.cpu = cpu;
+    for (uint32_t i = 0; i < 32; i++) {
+        new_hart.reg_lower[i] = static_cast<uint32_t>(cpu->reg[i]);
+    }
+    harts.push_back(new_hart);
+
+    // HARTSELLEN is the amount of bits it takes to number the harts
+    hartsel_mask = 0x00;
+    while (hartsel_mask < harts.size() - 1) {
+        hartsel_mask = (hartsel_mask << 1) | 0b1;
+    }
+
+    hart_array_mask.resize((harts.size() + 31) / 32, 0x00);
+
+    // the vector may have moved the harts
+    select_harts();
+}
+
+uint32_t DebugModule::get_hart_count() const
+{
+    return static_cast<uint32_t>(harts.size());
+}
+
+cpu_t* DebugModule::get_hart(uint32_t index)
+{
+    return harts[index].cpu;
+}
+
+void DebugModule::set_xlen(uint32_t xlen)
+{
+    if ((xlen != 32) && (xlen != 64))
+    {
+        fprintf(stderr, "[Error] unsupported XLEN %" PRIu32 ", only 32 and 64 are supported\n", xlen);
+        abort();
+    }
+
+    this->xlen = xlen;
+}
+
+uint8_t DebugModule::execute(uint32_t address, uint8_t op, uint32_t& data)
+{
+    const register_handler_t& handler = register_handlers.handlers[address & ABITS_MASK];
+
+    // a running hart executes one instruction per DMI access
+    if (running_hart_count != 0)
+    {
+        run_harts();
+    }
+
+    if (op == 0x01)
+    {
+        data = (this->*handler.read)(address);
+    }
+    else if (op == 0x02)
+    {
+        data = (this->*handler.write)(address, data);
+    }
+
+    // The DM completes every request right away, there is never a busy or failed DMI access.
+    // success, the operation 0x00 used in a response is interpreted by openocd
+    // as a successfull termination of the requested operation
+    return 0x00;
+}
+
+uint32_t DebugModule::read_unknown(uint32_t address)
+{
+    fprintf(stderr, "\nUPDATE_DR RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS -- [ERROR] UNKNOWN dmi_address!!! 0x%02x (%s) \n", address, register_as_string(address).c_str());
+    return 0x00;
+}
+
+uint32_t DebugModule::write_unknown(uint32_t address, uint32_t value)
+{
+    fprintf(stderr, "\nUPDATE_DR RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS -- [ERROR] UNKNOWN dmi_address!!! 0x%02x (%s) \n", address, register_as_string(address).c_str());
+    return value;
+}
+
+// data 0 through data 11 (Registers data 0 - data 11) are registers that may
+// be read or changed by abstract commands. datacount indicates how many
+// of them are implemented, starting at data0 counting up.
+//
+// Table 2 shows how abstract commands use these registers.
+
+uint32_t DebugModule::read_data(uint32_t address)
+{
+    uint32_t idx = address - 0x04;
+    uint32_t value = abstract_data[idx];
+
+#ifdef ABSTRACT_DATA_DEBUG // block transfers access the data registers once per word
+    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Abstract Data %d (data%d) (0x%02x) READ. value = %" PRIu32 "\n", idx, idx, idx, abstract_data[idx]);
+#endif
+
+    // the response carries the value from before the command runs again, the command
+    // typically fetches the next word into the register
+    if ((autoexecdata >> idx) & 0b1) {
+        execute_abstract_command();
+    }
+
+    return value;
+}
+
+uint32_t DebugModule::write_data(uint32_t address, uint32_t value)
+{
+    uint32_t idx = address - 0x04;
+
+#ifdef ABSTRACT_DATA_DEBUG // block transfers access the data registers once per word
+    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Abstract Data %d (data%d) (0x%02x) WRITE \n", idx, idx, idx);
+#endif
+
+    abstract_data[idx] = value;
+
+    if ((autoexecdata >> idx) & 0b1) {
+        execute_abstract_command();
+    }
+
+    return value;
+}
+
+// 0x10 == DebugModule Control Register (DebugSpec, Page 26 and Page 30)
+
+uint32_t DebugModule::get_dmcontrol()
+{
+    return (haltreq << 31) |        // Writing 0 clears the halt request bit for all currently selected harts.
+        (resumereq << 30) |         // Writing 1 causes the currently selected harts to resume once, if they are halted when the write occurs.
+        (hartreset << 29) |
+        (ackhavereset << 28) |
+        (ackunavail << 27) |
+        (hasel << 26) |
+        (hartsello << 16) |
+        (hartselhi << 6) |
+        (setkeepalive << 5) |
+        (clrkeepalive << 4) |
+        (setresethaltreq << 3) |
+        (clrresethaltreq << 2) |
+        (ndmreset << 1) |
+        (dmactive << 0);
+}
+
+uint32_t DebugModule::read_dmcontrol(uint32_t address)
+{
+    fprintf(stderr, "\nDebugModule Control Register READ\n");
+
+    return get_dmcontrol();
+}
+
+uint32_t DebugModule::write_dmcontrol(uint32_t address, uint32_t value)
+{
+    fprintf(stderr, "\nDebugModule Control Register WRITE\n");
+
+    // https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf
+
+    // parse the incoming fields
+    haltreq = ((value >> 31) & 0b1);             // Writing 0 clears the halt request bit for all currently selected harts.
+    resumereq = ((value >> 30) & 0b1);           // Writing 1 causes the currently selected harts to resume once, if they are halted when the write occurs.
+    hartreset = ((value >> 29) & 0b1);           // This optional field writes the reset bit for all the currently selected harts. To perform a reset the debugger writes 1, and then writes 0 to deassert the reset signal.
+    ackhavereset = ((value >> 28) & 0b1);
+    ackunavail = ((value >> 27) & 0b1);
+    hasel = ((value >> 26) & 0b1);
+    hartsello = ((value >> 16) & 0b1111111111);
+    hartselhi = ((value >> 6) & 0b1111111111);
+    setkeepalive = ((value >> 5) & 0b1);
+    clrkeepalive = ((value >> 4) & 0b1);
+    setresethaltreq = ((value >> 3) & 0b1);
+    clrresethaltreq = ((value >> 2) & 0b1);
+    ndmreset = ((value >> 1) & 0b1);
+    dmactive = ((value >> 0) & 0b1);             // This bit serves as a reset signal for the Debug Module itself. 0 triggers a reset. 1 causes the module to remain as is without reset.
+
+    fprintf(stderr, "\n");
+    fprintf(stderr, "haltreq: %d\n", haltreq);
+    fprintf(stderr, "resumereq: %d\n", resumereq);
+    fprintf(stderr, "hartreset: %d\n", hartreset);
+    fprintf(stderr, "ackhavereset: %d\n", ackhavereset);
+    fprintf(stderr, "ackunavail: %d\n", ackunavail);
+    fprintf(stderr, "hasel: %d\n", hasel);
+    fprintf(stderr, "hartsello: %d\n", hartsello);
+    fprintf(stderr, "hartselhi: %d\n", hartselhi);
+    fprintf(stderr, "setkeepalive: %d\n", setkeepalive);
+    fprintf(stderr, "clrkeepalive: %d\n", clrkeepalive);
+    fprintf(stderr, "setresethaltreq: %d\n", setresethaltreq);
+    fprintf(stderr, "clrresethaltreq: %d\n", clrresethaltreq);
+    fprintf(stderr, "ndmreset: %d\n", ndmreset);
+    fprintf(stderr, "dmactive: %d\n", dmactive);
+
+    // openocd does not know how many harts exist inside the DM.
+    // It will therefore perform a probe operation as outlined in the
+    // RISCV debug specification: page 30, 3.14.2 Debug Module Control (cmcontrol, 0x10)
+    // "A debugger should discover HARTSELLEN by writing all ones to hartsel (assuming
+    // the maximum size) and reading back the value to see which bits were actually set"
+    //
+    // hartsel is a name for the combined high and low registers {hartselhi, hartsello}.
+    // It is the index of the selected hart. Only the bits that it takes to number the
+    // harts are implemented, the others read back as 0. openocd then selects one hart
+    // after the other until dmstatus reports it as nonexistent.
+    //
+    // openocd sets hasel in the same write to find out whether there is a hart array mask.
+    uint32_t hartsel = ((hartselhi << 10) | hartsello) & hartsel_mask;
+    hartsello = hartsel & 0b1111111111;
+    hartselhi = (hartsel >> 10) & 0b1111111111;
+
+    select_harts();
+
+    for (uint32_t index = 0; index < harts.size(); index++) {
+
+        hart_t& selected = harts[index];
+        if (!is_selected(index)) {
+            continue;
+        }
+
+        // a halt request wins over a resume request
+        if ((haltreq == 1) && !selected.halted) {
+
+            fprintf(stderr, "\n[HALT] hart %d halts at pc 0x%08x\n", index, selected.cpu->pc);
+
+            halt_hart(selected, DCSR_CAUSE_HALTREQ);
+
+        } else if ((haltreq == 0) && (resumereq == 1) && selected.halted && !selected.dcsr_step) {
+
+            fprintf(stderr, "\n[RESUME] hart %d resumes at pc 0x%08x\n", index, selected.cpu->pc);
+
+            selected.halted = false;
+            selected.resumeack = true;
+            running_hart_count++;
+
+        } else if ((haltreq == 0) && (resumereq == 1) && selected.halted) {
+
+            // single step requested (dcsr.step)
+            auto t = std::time(nullptr);
+            auto tm = *std::localtime(&t);
+
+            std::ostringstream oss;
+            oss << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
+            auto str = oss.str();
+
+            std::cout << str << std::endl;
+
+            fprintf(stderr, "\n %s [SINGLE_STEP] hart %d performs single step requested!\n", str.c_str(), index);
+
+            cpu_step(selected.cpu);
+
+            selected.dpc = selected.cpu->pc;
+            selected.dcsr_cause = DCSR_CAUSE_STEP;
+            selected.resumeack = true;
+        }
+    }
+
+    // dm restart requested by writing a 1 into the dmactive bit of the dmcontrol register
+    if (dmactive == 1) {
+
+        fprintf(stderr, "\nDM activate or remain active (not reset) requested!\n");
+
+        // simulated restart - seen openocd source code. riscv-013.c, line 1839, "Activating the DM."
+        // openocd writes a 1 into the DM's dmactive bit to tell the DM to activate.
+        // openocd then performs a wait loop in which the bit is read. When the dmactive bit is
+        // eventually read a 1, then openocd continues with the next step.
+        //
+        // The next step is to select a hart.
+        dmactive = 1;
+    }
+
+    return get_dmcontrol();
+}
+
+// 0x11 == DebugModule Status (dmstatus) (DebugSpec, Page 28) - 3.14.1 Debug Module Status
+
+uint32_t DebugModule::read_dmstatus(uint32_t address)
+{
+#ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
+    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Status Register (0x11) READ \n");
+#endif
+
+    uint32_t ndmresetpending = 0x00;
+    uint32_t stickyunavail = 0x00;
+    uint32_t allhavereset = 0x00;
+    uint32_t anyhavereset = 0x00;
+    uint32_t allunavail = 0x00;
+    uint32_t anyunavail = 0x00;
+
+    // The any bits are set if the condition holds for any of the selected harts, the all
+    // bits if it holds for all of them. resumeack is checked by openocd after a resume or
+    // a single step (step command).
+    //
+    // the harts come up halted, which makes the openocd source code return
+    // an OK status for the method riscv013_get_hart_state() in src/target/riscv/riscv-013.c
+    uint32_t allresumeack = 0x01;
+    uint32_t anyresumeack = 0x00;
+    uint32_t allnonexistent = 0x01;
+    uint32_t anynonexistent = 0x00;
+    uint32_t allrunning = 0x01;
+    uint32_t anyrunning = 0x00;
+    uint32_t allhalted = 0x01;
+    uint32_t anyhalted = 0x00;
+
+    // hartsel may point behind the last hart
+    uint32_t hartsel = (hartselhi << 10) | hartsello;
+    if (hartsel >= harts.size()) {
+        anynonexistent = 0x01;
+    }
+
+    uint32_t selected_count = 0;
+    for (uint32_t index = 0; index < harts.size(); index++) {
+
+        if (!is_selected(index)) {
+            continue;
+        }
+        selected_count++;
+
+        const hart_t& selected = harts[index];
+        allresumeack &= selected.resumeack ? 0x01 : 0x00;
+        anyresumeack |= selected.resumeack ? 0x01 : 0x00;
+        allrunning &= selected.halted ? 0x00 : 0x01;
+        anyrunning |= selected.halted ? 0x00 : 0x01;
+        allhalted &= selected.halted ? 0x01 : 0x00;
+        anyhalted |= selected.halted ? 0x01 : 0x00;
+    }
+
+    if (selected_count == 0) {
+        allresumeack = 0x00;
+        allrunning = 0x00;
+        allhalted = 0x00;
+    } else {
+        allnonexistent = 0x00;
+    }
+
+    // automatically authenticate the debugger as otherwise openocd goes into failure and outputs
+    // this message: "Debugger is not authenticated to target Debug Module. (dmstatus=0x3). Use `riscv authdata_read` and `riscv authdata_write` commands to authenticate."
+    uint32_t authenticated = 0x01;
+
+    uint32_t authbusy = 0x00;
+    uint32_t hasresethaltreq = 0x00;
+    uint32_t confstrptrvalid = 0x00;
+
+    // into version, enter either 2 or 3 since openocd will err out if not compatible version is returned
+    // openocd for riscv supports the version constants 2 or 3
+    // 2 stands for 0.13 and 3 stands for 1.0
+    // see riscv_examine() in src/target/riscv/riscv.c in the openocd source code.
+    uint32_t version = 0x03;
+
+    // construct the response
+    uint64_t debug_module_status =
+        (ndmresetpending << 24) |
+        (stickyunavail << 23) |
+        (impebreak << 22) |
+        (allhavereset << 19) |
+        (anyhavereset << 18) |
+        (allresumeack << 17) |
+        (anyresumeack << 16) |
+        (allnonexistent << 15) |
+        (anynonexistent << 14) |
+        (allunavail << 13) |
+        (anyunavail << 12) |
+        (allrunning << 11) |
+        (anyrunning << 10) |
+        (allhalted << 9) |
+        (anyhalted << 8) |
+        (authenticated << 7) |
+        (authbusy << 6) |
+        (hasresethaltreq << 5) |
+        (confstrptrvalid << 4) |
+        (version << 0);
+
+    // after this, in the logs of openocd (log level -d4) there should be an output similar to this:
+    // "Debug: 2755 50698 riscv-013.c:411 riscv_log_dmi_scan(): read: dmstatus=0x283 {version=1_0 authenticated=true allhalted=1}"
+    return debug_module_status;
+}
+
+uint32_t DebugModule::write_dmstatus(uint32_t address, uint32_t value)
+{
+#ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
+    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Status Register (0x11) WRITE \n");
+#endif
+
+    // read-only, the response carries the status all the same
+    return read_dmstatus(address);
+}
+
+// 0x12 == DebugModule 0x12 (Hart Info (hartinfo)) (DebugSpec, https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf, Page 28) - 3.14.1 Debug Module Status
+//
+// This register gives information about the hart currently selected by hartsel.
+// This register is optional. If it is not present it should read all-zero.
+// If this register is included, the debugger can do more with the Program Buffer by writing programs which explicitly access the data and/or dscratch registers.
+// This entire register is read-only
+
+uint32_t DebugModule::read_hartinfo(uint32_t address)
+{
+    // this register is optional. If it is not present, return all zero
+    return 0x00;
+}
+
+uint32_t DebugModule::write_hartinfo(uint32_t address, uint32_t value)
+{
+    return value;
+}
+
+// 0x40 == Halt Summary 0 (haltsum0), 0x13 == Halt Summary 1 (haltsum1), read-only
+
+uint32_t DebugModule::read_haltsum(uint32_t address)
+{
+    // haltsum0 has a bit per hart of the 32 harts around hartsel,
+    // haltsum1 a bit per group of 32 harts of the 1024 harts around hartsel
+    uint32_t harts_per_bit = (address == 0x40) ? 1 : 32;
+
+    uint32_t hartsel = (hartselhi << 10) | hartsello;
+    uint32_t first = hartsel & ~(harts_per_bit * 32 - 1);
+
+    uint32_t value = 0x00;
+    for (uint32_t index = first; (index < harts.size()) && (index < first + harts_per_bit * 32); index++) {
+        if (harts[index].halted) {
+            value |= 1u << ((index - first) / harts_per_bit);
+        }
+    }
+
+    return value;
+}
+
+uint32_t DebugModule::write_haltsum(uint32_t address, uint32_t value)
+{
+    return read_haltsum(address);
+}
+
+// 0x14 == Hart Array Window Select (hawindowsel)
+
+uint32_t DebugModule::read_hawindowsel(uint32_t address)
+{
+    return hawindowsel;
+}
+
+uint32_t DebugModule::write_hawindowsel(uint32_t address, uint32_t value)
+{
+    // WARL, only the windows that contain harts can be selected
+    hawindowsel = std::min<uint32_t>(value & 0x7FFF, static_cast<uint32_t>(hart_array_mask.size()) - 1);
+
+    return hawindowsel;
+}
+
+// 0x15 == Hart Array Window (hawindow)
+
+uint32_t DebugModule::read_hawindow(uint32_t address)
+{
+    return hart_array_mask[hawindowsel];
+}
+
+uint32_t DebugModule::write_hawindow(uint32_t address, uint32_t value)
+{
+    // the bits of harts that do not exist are 0
+    uint32_t window_harts = std::min<uint32_t>(32, static_cast<uint32_t>(harts.size()) - hawindowsel * 32);
+    uint32_t existing = (window_harts == 32) ? 0xFFFFFFFF : ((1u << window_harts) - 1);
+
+    hart_array_mask[hawindowsel] = value & existing;
+
+    return hart_array_mask[hawindowsel];
+}
+
+bool DebugModule::is_selected(uint32_t index)
+{
+    if (index == ((hartselhi << 10) | hartsello)) {
+        return true;
+    }
+
+    return hasel && ((hart_array_mask[index / 32] >> (index % 32)) & 0b1);
+}
+
+void DebugModule::select_harts()
+{
+    // abstract commands only act on the hart hartsel points to
+    uint32_t hartsel = (hartselhi << 10) | hartsello;
+    hart = (hartsel < harts.size()) ? &harts[hartsel] : NULL;
+}
+
+// 3.14.6. Abstract Control and Status (abstractcs, at 0x16)
+
+uint32_t DebugModule::read_abstractcs(uint32_t address)
+{
+    return (progbufsize << 24) |
+        (busy << 12) |
+        (relaxedpriv << 11) |
+        (cmderr << 8) |
+        (datacount << 0);
+}
+
+uint32_t DebugModule::write_abstractcs(uint32_t address, uint32_t value)
+{
+    // progbufsize, busy and datacount are read-only, relaxedpriv is not implemented.
+    // cmderr is cleared by writing 1 to its bits.
+    cmderr &= ~((value >> 8) & 0b111);
+
+    return value;
+}
+
+// 3.14.7. Abstract Command (command, at 0x17)
+//
+// Register 0x17 is first written to start an abstract command to read a register for example.
+// Register 0x16 is then polled to see if the command has terminated
+// the resulting value is then read from register 0x04 for 32 bit and from
+// register 0x04 and 0x05 for 64 bit.
+
+uint32_t DebugModule::read_command(uint32_t address)
+{
+    // write-only, reads return 0
+    return 0x00;
+}
+
+uint32_t DebugModule::write_command(uint32_t address, uint32_t value)
+{
+    // Writes to this register cause the corresponding abstract command to be executed.
+    //
+    // Writing this register while an abstract command is executing causes cmderr to
+    // become 1 (busy) once the command completes (busy becomes 0).
+    //
+    // If cmderr is non-zero, writes to this register are ignored.
+    //
+    // cmderr inhibits starting a new command to accommodate debuggers that, for
+    // performance reasons, send several commands to be executed in a row without checking
+    // cmderr in between. They can safely do so and check cmderr at the end without worrying
+    // that one command failed but then a later command (which might have depended on the
+    // previous one succeeding) passed.
+    if (cmderr != 0x00) {
+        return value;
+    }
+
+    // kept for abstractauto, which executes the command again
+    command = value;
+
+    execute_abstract_command();
+
+    return value;
+}
+
+// 3.14.8. Abstract Command Autoexec (abstractauto, at 0x18)
+//
+// Lets the debugger stream data through an abstract command: every access to a data
+// register (or program buffer word) whose bit is set executes command once more. With
+// aampostincrement a block memory transfer takes a single DMI access per word.
+
+uint32_t DebugModule::read_abstractauto(uint32_t address)
+{
+    return (autoexecprogbuf << 16) |
+        (autoexecdata << 0);
+}
+
+uint32_t DebugModule::write_abstractauto(uint32_t address, uint32_t value)
+{
+    // WARL, only the bits of implemented data and program buffer registers stick
+    autoexecprogbuf = (value >> 16) & ((1u << progbufsize) - 1);
+    autoexecdata = (value >> 0) & ((1u << datacount) - 1);
+
+    return read_abstractauto(address);
+}
+
+void DebugModule::execute_abstract_command()
+{
+    if (cmderr != 0x00) {
+        return;
+    }
+
+    // hartsel points to a hart that does not exist
+    if (hart == NULL) {
+        cmderr = 0x04;
+        return;
+    }
+
+    // cmdtype: 0, control: 3280904
+    uint32_t cmdtype = ((command >> 24) & 0xFF);
+    uint32_t control = ((command >> 0) & 0xFFFFFF);
+
+    // DEBUG
+    //fprintf(stderr, "\ncmdtype: %d, control: %d\n", cmdtype, control);
+
+    // determine which type of abstract command is executed
+    if (cmdtype == 0x00) {
+
+        access_register(control);
+
+    } else if (cmdtype == 0x01) {
+
+        quick_access();
+
+    } else if (cmdtype == 0x02) {
+
+        access_memory(command);
+
+    } else {
+
+        // unknown cmdtype
+        cmderr = 0x02;
+
+    }
+}
+
+// 3.14.18. Program Buffer 0 (progbuf0, at 0x20) - Program Buffer 15 (progbuf15, at 0x2f)
+//
+// openocd places short instruction sequences (memory accesses, fence, csr accesses) into
+// the program buffer and runs them with postexec. They run on the hart itself, out of a
+// scratch area of its memory image that holds the buffer followed by the implicit ebreak.
+
+// where the program buffer is executed from, the top of the 32 bit address space
+#define PROGRAM_BUFFER_ADDRESS 0xFFFFFF00
+
+// the program buffer may loop, but not forever
+#define PROGRAM_BUFFER_MAX_STEPS 4096
+
+#define INSTRUCTION_EBREAK 0x00100073
+
+uint32_t DebugModule::read_progbuf(uint32_t address)
+{
+    uint32_t idx = address - 0x20;
+    uint32_t value = progbuf[idx];
+
+    if ((autoexecprogbuf >> idx) & 0b1) {
+        execute_abstract_command();
+    }
+
+    return value;
+}
+
+uint32_t DebugModule::write_progbuf(uint32_t address, uint32_t value)
+{
+    uint32_t idx = address - 0x20;
+    progbuf[idx] = value;
+
+    if ((autoexecprogbuf >> idx) & 0b1) {
+        execute_abstract_command();
+    }
+
+    return value;
+}
+
+void DebugModule::execute_program_buffer()
+{
+    // the buffer and the implicit ebreak behind it
+    uint8_t* memory = get_memory(PROGRAM_BUFFER_ADDRESS);
+    for (uint32_t i = 0; i <= progbufsize; i++) {
+        uint32_t instruction = (i < progbufsize) ? progbuf[i] : INSTRUCTION_EBREAK;
+        for (uint32_t byte = 0; byte < 4; byte++) {
+            memory[i * 4 + byte] = static_cast<uint8_t>(instruction >> (byte * 8));
+        }
+    }
+
+    // the hart is halted at dpc and returns there once the buffer is done
+    cpu_t* cpu = hart->cpu;
+    uint32_t halted_pc = cpu->pc;
+    cpu->pc = PROGRAM_BUFFER_ADDRESS;
+
+    uint32_t steps = 0;
+    while (true) {
+
+        // jumps out of the program buffer are not allowed
+        uint32_t offset = cpu->pc - PROGRAM_BUFFER_ADDRESS;
+        if ((offset > progbufsize * 4) || (steps == PROGRAM_BUFFER_MAX_STEPS)) {
+            fprintf(stderr, "[ERROR] program buffer left at pc 0x%08x after %d steps\n", cpu->pc, steps);
+            cmderr = 0x03;
+            break;
+        }
+
+        // ebreak (or c.ebreak) returns to the debug module
+        uint32_t instruction;
+        memcpy(&instruction, memory + offset, sizeof(instruction));
+        if ((instruction == INSTRUCTION_EBREAK) || ((instruction & 0xFFFF) == 0x9002)) {
+            break;
+        }
+
+        if (cpu_step(cpu)) {
+            fprintf(stderr, "[ERROR] exception inside the program buffer at pc 0x%08x\n", cpu->pc);
+            cmderr = 0x03;
+            break;
+        }
+        steps++;
+    }
+
+    cpu->pc = halted_pc;
+}
+
+// 3.14.22. System Bus Access Control and Status (sbcs, at 0x38)
+//
+// System Bus Access reads and writes the memory of the hart without involving the hart,
+// which makes it the fastest way for openocd to access memory. With sbautoincrement and
+// sbreadondata (or a write of sbdata0 for writes) a block transfer takes one DMI access per
+// word. Every bus access completes right away, so sbbusy is never set.
+
+// size of a segment of the memory image in bytes (see IHexLoader)
+#define MEMORY_SEGMENT_SIZE 0x10000
+
+uint32_t DebugModule::read_sbcs(uint32_t address)
+{
+    // 1: the System Bus interface conforms to version 1.0 of the spec
+    uint32_t sbversion = 0x01;
+
+    // width of the system bus address
+    uint32_t sbasize = 64;
+
+    return (sbversion << 29) |
+        (sbbusyerror << 22) |
+        (sbreadonaddr << 20) |
+        (sbaccess << 17) |
+        (sbautoincrement << 16) |
+        (sbreadondata << 15) |
+        (sberror << 12) |
+        (sbasize << 5) |
+        (0b01111 << 0); // 64, 32, 16 and 8 bit accesses are supported, 128 bit ones are not
+}
+
+uint32_t DebugModule::write_sbcs(uint32_t address, uint32_t value)
+{
+    // the error bits are cleared by writing 1
+    sbbusyerror &= ~((value >> 22) & 0b1);
+    sberror &= ~((value >> 12) & 0b111);
+
+    sbreadonaddr = (value >> 20) & 0b1;
+    sbaccess = (value >> 17) & 0b111;
+    sbautoincrement = (value >> 16) & 0b1;
+    sbreadondata = (value >> 15) & 0b1;
+
+    return read_sbcs(address);
+}
+
+uint32_t DebugModule::read_sbaddress(uint32_t address)
+{
+    return static_cast<uint32_t>(sbaddress >> ((address - 0x39) * 32));
+}
+
+uint32_t DebugModule::write_sbaddress(uint32_t address, uint32_t value)
+{
+    if (address == 0x3a) {
+        sbaddress = (static_cast<uint64_t>(value) << 32) | (sbaddress & 0xFFFFFFFF);
+        return value;
+    }
+
+    sbaddress = (sbaddress & 0xFFFFFFFF00000000ULL) | value;
+
+    if (sbreadonaddr) {
+        system_bus_read();
+    }
+
+    return value;
+}
+
+uint32_t DebugModule::read_sbdata(uint32_t address)
+{
+    uint32_t value = static_cast<uint32_t>(sbdata >> ((address - 0x3c) * 32));
+
+    // only a read of sbdata0 starts the next read, the debugger reads sbdata1 first
+    if ((address == 0x3c) && sbreadondata) {
+        system_bus_read();
+    }
+
+    return value;
+}
+
+uint32_t DebugModule::write_sbdata(uint32_t address, uint32_t value)
+{
+    if (address == 0x3d) {
+        sbdata = (static_cast<uint64_t>(value) << 32) | (sbdata & 0xFFFFFFFF);
+        return value;
+    }
+
+    sbdata = (sbdata & 0xFFFFFFFF00000000ULL) | value;
+
+    system_bus_write();
+
+    return value;
+}
+
+void DebugModule::system_bus_read()
+{
+    if ((sberror != 0x00) || (sbbusyerror != 0x00)) {
+        return;
+    }
+
+    uint32_t size = 1u << sbaccess;
+    if (sbaccess > 3) {
+        sberror = 0x04;
+        return;
+    }
+
+    sberror = check_memory_access(sbaddress, size);
+    if (sberror != 0x00) {
+        return;
+    }
+
+    sbdata = read_memory(static_cast<uint32_t>(sbaddress), size);
+
+    if (sbautoincrement) {
+        sbaddress += size;
+    }
+}
+
+void DebugModule::system_bus_write()
+{
+    if ((sberror != 0x00) || (sbbusyerror != 0x00)) {
+        return;
+    }
+
+    uint32_t size = 1u << sbaccess;
+    if (sbaccess > 3) {
+        sberror = 0x04;
+        return;
+    }
+
+    sberror = check_memory_access(sbaddress, size);
+    if (sberror != 0x00) {
+        return;
+    }
+
+    write_memory(static_cast<uint32_t>(sbaddress), size, sbdata);
+
+    if (sbautoincrement) {
+        sbaddress += size;
+    }
+}
+
+uint32_t DebugModule::check_memory_access(uint64_t address, uint32_t size)
+{
+    // the hart has a 32 bit address space
+    if ((address + size - 1) > 0xFFFFFFFFULL) {
+        return 0x02;
+    }
+
+    // aligned accesses never cross a segment
+    if ((address & (size - 1)) != 0) {
+        return 0x03;
+    }
+
+    return 0x00;
+}
+
+uint64_t DebugModule::read_memory(uint32_t address, uint32_t size)
+{
+    // the memory image is little endian just like the host, bytes beyond the access size read as 0
+    uint64_t value = 0x00;
+    memcpy(&value, get_memory(address), size);
+    return value;
+}
+
+void DebugModule::write_memory(uint32_t address, uint32_t size, uint64_t value)
+{
+    memcpy(get_memory(address), &value, size);
+}
+
+uint8_t* DebugModule::get_memory(uint32_t address)
+{
+    uint32_t segment_address = address & ~static_cast<uint32_t>(MEMORY_SEGMENT_SIZE - 1);
+
+    if ((cached_segment == NULL) || (segment_address != cached_segment_address)) {
+
+        // check if the segment is created already otherwise create it
+        // the harts share the memory image of the first one
+        std::map<uint32_t, uint32_t *>* segments = harts[0].cpu->segments;
+
+        std::map<uint32_t, uint32_t *>::iterator it = segments->find(segment_address);
+        if (it == segments->end()) {
+            uint32_t* segment_ptr = new uint32_t[MEMORY_SEGMENT_SIZE / sizeof(uint32_t)]();
+            it = segments->insert(std::pair<uint32_t, uint32_t*>(segment_address, segment_ptr)).first;
+        }
+
+        cached_segment_address = segment_address;
+        cached_segment = reinterpret_cast<uint8_t*>(it->second);
+    }
+
+    return cached_segment + (address - segment_address);
+}
+
+// 3.7.1.1. Access Register, page 18
+
+void DebugModule::access_register(uint32_t control)
+{
+    uint32_t regno = (control >> 0) & 0xFFFF;
+    uint32_t write = (control >> 16) & 0x01;
+    uint32_t transfer = (control >> 17) & 0x01;
+    uint32_t postexec = (control >> 18) & 0x01;
+    uint32_t aarpostincrement = (control >> 19) & 0x01;
+    uint32_t aarsize = (control >> 20) & 0b111;
+
+    // registers are only accessible while the hart is halted
+    if ((transfer || postexec) && !hart->halted) {
+        cmderr = 0x04;
+        return;
+    }
+
+    // Check if the request has specified the correct register size XLEN.
+    // If the sent size is larger than XLEN, the debug interface has
+    // to set cmderr to 0x02. A smaller size accesses the low bits of the register.
+    //
+    // openocd uses this as the "separate non-standard mechanism" to determine XLEN (register size):
+    // it reads s0 with 64 bit and falls back to 32 bit if that fails
+    if (transfer && ((aarsize < 2) || (aarsize > 3) || ((32u << (aarsize - 2)) > xlen))) {
+
+        // if any of these operations fail, cmderr is set
+        // and none of the remaining steps are executed.
+
+        // if a command has unsupported options set or if bits that are
+        // defined as zero are not 0, then the DM must set cmderr to 2 (not supported)
+        cmderr = 0x02;
+        return;
+    }
+
+    if (transfer) {
+        transfer_register(regno, write, 32u << (aarsize - 2));
+    }
+
+    // the next command accesses the next register, so that openocd can read the register file
+    // with abstractauto and a single command
+    if (transfer && aarpostincrement && (cmderr == 0x00)) {
+        command = (command & ~0xFFFFu) | ((regno + 1) & 0xFFFF);
+    }
+
+    // execute the program buffer once the register has been transferred
+    if (postexec && (cmderr == 0x00)) {
+        execute_program_buffer();
+    }
+}
+
+void DebugModule::transfer_register(uint32_t regno, uint32_t write, uint32_t width)
+{
+    fprintf(stderr, "\nACCESS REGISTER COMMAND regno: %" PRIu32 " (0x%04x), ABI-Name: %s\n", regno, regno, riscv_register_as_string(regno).c_str());
+
+    // try for one of the registers in the register file. GDB will offset them by 0x1000.
+    uint32_t regno_without_offset = regno - 0x1000;
+    if (regno_without_offset <= 31) {
+
+        fprintf(stderr, "\nACCESS REGISTER COMMAND found register from the register file\n");
+
+        if (write == 0) {
+
+            fprintf(stderr, "reading %s\n", riscv_register_as_string(regno_without_offset).c_str());
+
+            // the upper half only belongs to the lower half the debugger has written with it
+            uint32_t lower = static_cast<uint32_t>(hart->cpu->reg[regno_without_offset]);
+            uint32_t upper = hart->reg_upper[regno_without_offset];
+            if (lower != hart->reg_lower[regno_without_offset]) {
+                upper = (lower & 0x80000000) ? 0xFFFFFFFF : 0x00000000;
+            }
+
+            set_abstract_arg(0, width, (static_cast<uint64_t>(upper) << 32) | lower);
+
+        } else if (write == 1) {
+
+            fprintf(stderr, "writing %s\n", riscv_register_as_string(regno_without_offset).c_str());
+
+            // zero is hard wired
+            if (regno_without_offset != 0) {
+                uint64_t value = get_abstract_arg(0, width);
+                hart->cpu->reg[regno_without_offset] = static_cast<uint32_t>(value);
+                hart->reg_upper[regno_without_offset] = static_cast<uint32_t>(value >> 32);
+                hart->reg_lower[regno_without_offset] = static_cast<uint32_t>(value);
+            }
+
+        }
+
+    } else if (regno == 0x300) {
+
+        // CSR_MSTATUS register - Zicsr extension
+        //
+        // https://book.rvemu.app/hardware-components/03-csrs.html
+        //
+        // The status registers, mstatus for M-mode and sstatus for S-mode,
+        // keep track of and control the CPU's current operating status.
+        //
+        // mstatus is allocated at 0x300 and sstatus is allocated at 0x100.
+        // It means we can access status registers by 0x300 and 0x100.
+
+        // 3.1.6 Machine Status Registers (mstatus and mstatush)
+        // The mstatus register is an MXLEN-bit read/write register formatted as
+        //shown in Figure 1.6 for RV32 and Figure 1.7 for RV64. The mstatus register
+        // keeps track of and controls the hart’s current operating state.
+        //
+        // A restricted view of mstatus appears as the sstatus register in the S-level ISA.
+
+        // https://five-embeddev.com/quickref/csrs.html
+
+        // [31]     SD          - Extension Context - Read-only bit that summarizes whether either the FS, VS or XS fields signal the presence of some dirty state that will require saving extended user context to memory.
+        // [30-23]  WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
+        // [22]     TSR         - The TSR (Trap SRET) bit is a WARL field that supports intercepting the supervisor exception return instruction, SRET.
+        // [21]     TW          - The TW (Timeout Wait) bit is a WARL field that supports intercepting the WFI instruction.
+        // [20]     TVM         - The TVM (Trap Virtual Memory) bit is a WARL field that supports intercepting supervisor virtual-memory management operations.
+        // [19]     MXR         - The MXR (Make eXecutable Readable) bit modifies the privilege with which loads access virtual memory. 0 - Only loads from pages marked readable will succeed. 1 - Loads from pages marked either readable or executable will succeed.
+        // [18]     SUM         - The SUM (permit Supervisor User Memory access) bit modifies the privilege with which S-mode loads and stores access virtual memory. 0 - S-mode memory accesses to pages that are accessible by U-mode will fault. 1. - S-mode memory accesses to pages that are accessible by U-mode are permitted.
+        // [17]     MPRV        - Modify Privilege
+        // [16-15]  XS[1:0]     - The XS field encodes the status of additional user-mode extensions and associated state.
+        // [14-13]  FS[1:0]     - The FS field encodes the status of the floating-point unit state, including the floating-point registers f0–f31 and the CSRs fcsr, frm, and fflags.
+        // [12-11]  MPP[1:0]    - Machine Previous Privilege mode. Two-level stack
+        // [10-9]   VS[1:0]     - The VS field encodes the status of the vector extension state, including the vector registers v0–v31 and the CSRs vcsr, vxrm, vxsat, vstart, vl, vtype, and vlenb.
+        // [8]      SPP         - Supervisor Previous Privilege mode
+        // [7]      MPIE        - Machine Prior Interrupt Enable
+        // [6]      UBE         - Endianness Control - Control the endianness of memory accesses made from S-mode other than instruction fetches. (Instruction fetches are always little-endian). 0 - Little Endian. 1 - Big Endian.
+        // [5]      SPIE        - Supervisor Prior Interrupt Enable
+        // [4]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
+        // [3]      MIE         - Machine Interrupt Enable - Global Interupt Enable (in M-Mode) (M-Mode = Machine Mode = application has full access)
+        // [2]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
+        // [1]      SIE         - Supervisor Interrupt Enable - Global Interupt Enable (in S-Mode) (S-Mode = Supervisor Mode = application has limited access)
+        // [0]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
+    } else if (regno == 0x301) {
+
+        // CSR_MISA register - Zicsr extension
+        //
+        // https://book.rvemu.app/hardware-components/03-csrs.html
+        // https://five-embeddev.com/riscv-priv-isa-manual/Priv-v1.12/machine.html
+        //
+        // Register 0x17 is first written to start an abstract command to read a register for example.
+        // Register 0x16 is then polled to see if the command has terminated
+        //
+        // The resulting value is then read from register 0 (0x04) for 32 bit
+        // and from register 0 (0x04) and 1 (0x05) for 64 bit.
+        if (write == 0) {
+
+            fprintf(stderr, "read CSR_MISA (0x301)\n");
+
+            // MXL is stored in the two most significant bits: 1 is XLEN 32, 2 is XLEN 64
+            //                 ZYXWVUTSRQPONMLKJIHGFEDCBA
+            uint64_t misa = 0b00000000000000000100101000;
+            uint64_t mxl = (xlen == 64) ? 0x02 : 0x01;
+
+            set_abstract_arg(0, width, misa | (mxl << (xlen - 2)));
+
+        } else if (write == 1) {
+
+            fprintf(stderr, "write CSR_MISA (0x301)\n");
+        }
+
+    } else if (regno == 0x07b0) {
+
+        // 4.8.1 Debug Control and Status (dcsr, at 0x7b0)
+
+        // xdebugver [31-28]    0: There is no external debug support.
+        //                      4: External debug support exists as it is described in this document.
+        //                      15: There is external debug support, but it does not conform to any available version of this spec.
+        // 0         [27-16]
+        // ebreakm   [15]       0: ebreak instructions in M-mode behave as described in the Privileged Spec.
+        //                      1: ebreak instructions in M-mode enter Debug Mode.
+        // 0         [14]
+        // ebreaks   [13]       0: ebreak instructions in S-mode behave as described in the Privileged Spec.
+        //                      1: ebreak instructions in S-mode enter Debug Mode.
+        // ebreaku   [12]       0: ebreak instructions in U-mode behave as described in the Privileged Spec.
+        //                      1: ebreak instructions in U-mode enter Debug Mode.
+        // stepie    [11]       0: Interrupts are disabled during single stepping.
+        //                      1: Interrupts are enabled during single stepping.
+        //                      Implementations may hard wire this bit to 0. In
+        //                      that case interrupt behavior can be emulated by
+        //                      the debugger.
+        //                      The debugger must not change the value of this
+        //                      bit while the hart is running.
+        // stopcount [10]       0: Increment counters as usual.
+        //                      1: Don’t increment any counters while in Debug
+        //                      Mode or on ebreak instructions that cause entry into Debug Mode.
+        //                      These counters include the cycle and instret CSRs.
+        //                      This is preferred for most debugging scenarios.
+        //                      An implementation may hardwire this bit to 0 or 1.
+        //                      Stop Counters.
+        // stoptime  [9]        0: Increment timers as usual.
+        //                      1: Don’t increment any hart-local timers while in Debug Mode.
+        //                      An implementation may hardwire this bit to 0 or 1.
+        //                      Stop timers.
+        // cause     [8-6]      Explains why Debug Mode was entered.
+        //                      When there are multiple reasons to enter Debug
+        //                      Mode in a single cycle, hardware should set cause
+        //                      to the cause with the highest priority.
+        //                      1: An ebreak instruction was executed. (priority 3)
+        //                      2: The Trigger Module caused a breakpoint exception. (priority 4, highest)
+        //                      3: The debugger requested entry to Debug Mode using haltreq. (priority 1)
+        //                      4: The hart single stepped because step was set. (priority 0, lowest)
+        //                      5: The hart halted directly out of reset due to resethaltreq. It is also acceptable to report 3 when
+        //                      this happens. (priority 2)
+        //                      Other values are reserved for future use.
+        // 0         [5]
+        // mprven    [4]        0: MPRV in mstatus is ignored in Debug Mode.
+        //                      1: MPRV in mstatus takes effect in Debug Mode.
+        //                      Implementing this bit is optional. It may be tied to either 0 or 1.
+        // nmip      [3]        When set, there is a Non-Maskable-Interrupt
+        //                      (NMI) pending for the hart.
+        //                      Since an NMI can indicate a hardware error condition, reliable debugging may no longer be possible
+        //                      once this bit becomes set. This is implementationdependent.
+        // step      [2]        When set and not in Debug Mode, the hart will only execute a single instruction and then enter Debug Mode.
+        //                      If the instruction does not complete due to an exception, the hart will immediately enter Debug Mode before executing the trap
+        //                      handler, with appropriate exception registers set.
+        //                      The debugger must not change the value of this
+        //                      bit while the hart is running.
+        // prv       [1-0]      Contains the privilege level the hart was operating
+        //                      in when Debug Mode was entered. The encoding
+        //                      is described in Table 4.5. A debugger can change
+        //                      this value to change the hart’s privilege level when
+        //                      exiting Debug Mode.
+        //                      Not all privilege levels are supported on all harts.
+        //                      If the encoding written is not supported or the
+        //                      debugger is not allowed to change to it, the hart
+        //                      may change to any supported privilege level.
+        if (write == 0) {
+
+            fprintf(stderr, "read dcsr (0x07b0)\n");
+
+            // xdebugver 4, M-mode
+            uint32_t dcsr = (0x04 << 28) | (hart->dcsr_cause << 6) | (hart->dcsr_step << 2) | 0x03;
+
+            set_abstract_arg(0, width, dcsr);
+
+        } else if (write == 1) {
+
+            fprintf(stderr, "write dcsr (0x07b0)\n");
+
+            // step is the only writable field
+            hart->dcsr_step = (get_abstract_arg(0, width) >> 2) & 0b1;
+
+        }
+
+    } else if (regno == 0x07b1) {
+
+        // 4.8.2 Debug PC (dpc, at 0x7b1)
+        //
+        // Upon entry to debug mode, dpc is updated with the virtual address of
+        // the next instruction to be executed. The behavior is described in more detail in Table 4.3.
+        //
+        // When resuming, the hart’s PC is updated to the virtual address stored in dpc.
+        // A debugger may write dpc to change where the hart resumes.
+        if (write == 0) {
+
+            fprintf(stderr, "read dpc (0x07b1)\n");
+
+            set_abstract_arg(0, width, hart->dpc);
+
+        } else if (write == 1) {
+
+            fprintf(stderr, "write dpc (0x07b1)\n");
+
+            // the hart is halted, it resumes at dpc
+            hart->dpc = get_abstract_arg(0, width);
+            hart->cpu->pc = static_cast<uint32_t>(hart->dpc);
+
+        }
+
+    } else {
+
+        fprintf(stderr, "\n[ERROR] Abstract Command (command, at 0x17) - ACCESS REGISTER COMMAND - UNKNOWN REGISTER !!!!! ACCESS REGISTER COMMAND write regno: %" PRIu32 " (0x%04x), ABI-Name: %s\n", regno, regno, riscv_register_as_string(regno).c_str());
+
+    }
+}
+
+// 3.7.1.2. Quick Access
+
+void DebugModule::quick_access()
+{
+    // the hart has to be running, the command halts it
+    if (hart->halted) {
+        cmderr = 0x04;
+        return;
+    }
+
+    fprintf(stderr, "\nQUICK_ACCESS at pc 0x%08x\n", hart->cpu->pc);
+
+    // halt, the hart stays in the program buffer for the duration of the command only and
+    // does not report the halt
+    hart->dpc = hart->cpu->pc;
+
+    // an exception sets cmderr to 3 but the hart resumes nevertheless
+    execute_program_buffer();
+
+    // resume at the pc the hart has been halted at
+    hart->cpu->pc = static_cast<uint32_t>(hart->dpc);
+}
+
+void DebugModule::run_harts()
+{
+    for (uint32_t index = 0; index < harts.size(); index++) {
+
+        hart_t& running = harts[index];
+        if (running.halted) {
+            continue;
+        }
+
+        if (cpu_step(running.cpu)) {
+
+            // the hart has stopped (ebreak or an exception), it enters Debug Mode
+            fprintf(stderr, "\n[HALT] hart %d stopped at pc 0x%08x\n", index, running.cpu->pc);
+
+            halt_hart(running, DCSR_CAUSE_EBREAK);
+        }
+    }
+}
+
+void DebugModule::halt_hart(hart_t& halting, uint32_t cause)
+{
+    if (!halting.halted) {
+        running_hart_count--;
+    }
+
+    halting.halted = true;
+    halting.dpc = halting.cpu->pc;
+    halting.dcsr_cause = cause;
+}
+
+// 3.7.1.3. Access Memory, page 20
+
+void DebugModule::access_memory(uint32_t command)
+{
+    // This table defines what registers are used for arg0, arg1 and arg2
+    //
+    // "Table 2 Use of Data Registers", DebugSpec, page 17
+    //
+    // argument width | arg0 (return) | arg1         | arg2
+    // 32             | data0         | data1        | data2
+    // 64             | data0, data1  | data2, data3 | data4, data5
+    // 128            | data0+1+2+3   | data4+5+6+7  | data8+9+10+11
+    //
+    // The address (arg1) and the value (arg0) are XLEN bits wide, see write_abstract_arg() in
+    // src/target/riscv/riscv-013.c of openocd. With XLEN 32 the address is in data1, a 64 bit
+    // value would overlap it, so accesses wider than XLEN are not supported.
+    //
+    // see Debug Spec, page 20 and page21
+
+    // aamvirtual (bit 23) is ignored, there is no MMU and virtual addresses are physical ones
+    uint32_t aamsize = ((command >> 20) & 0b111);
+    uint32_t aampostincrement = ((command >> 19) & 0b1);
+    uint32_t write = ((command >> 16) & 0b1);
+
+    // 8, 16, 32 and (with XLEN 64) 64 bit accesses, there is no 128 bit memory
+    if ((aamsize > 3) || ((8u << aamsize) > xlen)) {
+        cmderr = 0x02;
+        return;
+    }
+
+    uint32_t size = 1u << aamsize;
+    uint64_t address = get_abstract_arg(1, xlen);
+
+    if (check_memory_access(address, size) != 0x00) {
+
+        // alignment and bad addresses are bus errors
+        cmderr = 0x05;
+        return;
+    }
+
+    if (write) {
+
+        uint64_t value = get_abstract_arg(0, xlen);
+
+#ifdef ABSTRACT_DATA_DEBUG // block transfers access the data registers once per word
+        fprintf(stderr, "ACCESS_MEMORY_COMMAND +++ WRITE 0x%08" PRIx64 " -> 0x%08" PRIx64 " \n", value, address);
+#endif
+
+        write_memory(static_cast<uint32_t>(address), size, value);
+
+    } else {
+
+#ifdef ABSTRACT_DATA_DEBUG // block transfers access the data registers once per word
+        fprintf(stderr, "ACCESS_MEMORY_COMMAND +++ READ address: 0x%08" PRIx64 " \n", address);
+#endif
+
+        set_abstract_arg(0, xlen, read_memory(static_cast<uint32_t>(address), size));
+
+    }
+
+    // When the external debugger retrieves an incremented
+    // address, it knows that the auto-increment (aampostincrement) feature
+    // is implemented
+    if (aampostincrement) {
+        uint64_t address_mask = (xlen == 64) ? ~0ull : 0xFFFFFFFFull;
+        set_abstract_arg(1, xlen, (address + size) & address_mask);
+    }
+}
+
+uint64_t DebugModule::get_abstract_arg(uint32_t index, uint32_t width)
+{
+    // argument width | arg0 (return) | arg1         | arg2
+    // 32             | data0         | data1        | data2
+    // 64             | data0, data1  | data2, data3 | data4, data5
+    uint32_t first = index * (width / 32);
+
+    uint64_t value = abstract_data[first];
+    if (width == 64) {
+        value |= static_cast<uint64_t>(abstract_data[first + 1]) << 32;
+    }
+
+    return value;
+}
+
+void DebugModule::set_abstract_arg(uint32_t index, uint32_t width, uint64_t value)
+{
+    uint32_t first = index * (width / 32);
+
+    abstract_data[first] = static_cast<uint32_t>(value);
+    if (width == 64) {
+        abstract_data[first + 1] = static_cast<uint32_t>(value >> 32);
+    }
+}
+
+std::string DebugModule::register_as_string(uint32_t address) {
+    switch (address) {
+
+        case 0x04:
+            return std::string("Abstract Data 0 (data0)");
+        case 0x05:
+            return std::string("Abstract Data 1 (data1)");
+        case 0x06:
+            return std::string("Abstract Data 2 (data2)");
+        case 0x07:
+            return std::string("Abstract Data 3 (data3)");
+        case 0x08:
+            return std::string("Abstract Data 4 (data4)");
+        case 0x09:
+            return std::string("Abstract Data 5 (data5)");
+        case 0x0a:
+            return std::string("Abstract Data 6 (data6)");
+        case 0x0b:
+            return std::string("Abstract Data 7 (data7)");
+        case 0x0c:
+            return std::string("Abstract Data 8 (data8)");
+        case 0x0d:
+            return std::string("Abstract Data 9 (data9)");
+        case 0x0e:
+            return std::string("Abstract Data 10 (data10)");
+        case 0x0f:
+            return std::string("Abstract Data 11 (data11)");
+
+        case 0x10:
+            return std::string("Debug Module Control (dmcontrol)");
+        case 0x11:
+            return std::string("Debug Module Status (dmstatus)");
+        case 0x12:
+            return std::string("Hart Info (hartinfo)");
+        case 0x13:
+            return std::string("Halt Summary 1 (haltsum1)");
+        case 0x14:
+            return std::string("Hart Array Window Select (hawindowsel)");
+        case 0x15:
+            return std::string("Hart Array Window (hawindow)");
+        case 0x16:
+            return std::string("Abstract Control and Status (abstractcs)");
+        case 0x17:
+            return std::string("Abstract Command (command)");
+        case 0x18:
+            return std::string("Abstract Command Autoexec (abstractauto)");
+        case 0x19:
+            return std::string("Configuration Structure Pointer 0 (confstrptr0)");
+        case 0x1a:
+            return std::string("Configuration Structure Pointer 1 (confstrptr1)");
+        case 0x1b:
+            return std::string("Configuration Structure Pointer 2 (confstrptr2)");
+        case 0x1c:
+            return std::string("Configuration Structure Pointer 3 (confstrptr3)");
+        case 0x1d:
+            return std::string("Next Debug Module (nextdm)");
+        //case 0x1e:
+        //    return std::string("");
+        case 0x1f:
+            return std::string("Custom Features (custom)");
+
+        case 0x20:
+            return std::string("Program Buffer 0 (progbuf0)");
+        case 0x21:
+            return std::string("Program Buffer 1 (progbuf1)");
+        case 0x22:
+            return std::string("Program Buffer 2 (progbuf2)");
+        case 0x23:
+            return std::string("Program Buffer 3 (progbuf3)");
+        case 0x24:
+            return std::string("Program Buffer 4 (progbuf4)");
+        case 0x25:
+            return std::string("Program Buffer 5 (progbuf5)");
+        case 0x26:
+            return std::string("Program Buffer 6 (progbuf6)");
+        case 0x27:
+            return std::string("Program Buffer 7 (progbuf7)");
+        case 0x28:
+            return std::string("Program Buffer 8 (progbuf8)");
+        case 0x29:
+            return std::string("Program Buffer 9 (progbuf9)");
+        case 0x2a:
+            return std::string("Program Buffer 10 (progbuf10)");
+        case 0x2b:
+            return std::string("Program Buffer 11 (progbuf11)");
+        case 0x2c:
+            return std::string("Program Buffer 12 (progbuf12)");
+        case 0x2d:
+            return std::string("Program Buffer 13 (progbuf13)");
+        case 0x2e:
+            return std::string("Program Buffer 14 (progbuf14)");
+        case 0x2f:
+            return std::string("Program Buffer 15 (progbuf15)");
+
+        case 0x30:
+            return std::string("Authentication Data (authdata)");
+        // case 0x31:
+        //     return std::string("");
+        case 0x32:
+            return std::string("Debug Module Control and Status 2 (dmcs2)");
+        // case 0x33:
+        //     return std::string("");
+        case 0x34:
+            return std::string("Halt Summary 2 (haltsum2)");
+        case 0x35:
+            return std::string("Halt Summary 3 (haltsum3)");
+        // case 0x36:
+        //     return std::string("");
+        case 0x37:
+            return std::string("System Bus Address 127:96 (sbaddress3)");
+        case 0x38:
+            return std::string("System Bus Access Control and Status (sbcs)");
+        case 0x39:
+            return std::string("System Bus Address 31:0 (sbaddress0)");
+        case 0x3a:
+            return std::string("System Bus Address 63:32 (sbaddress1)");
+        case 0x3b:
+            return std::string("System Bus Address 95:64 (sbaddress2)");
+        case 0x3c:
+            return std::string("System Bus Data 31:0 (sbdata0)");
+        case 0x3d:
+            return std::string("System Bus Data 63:32 (sbdata1)");
+        case 0x3e:
+            return std::string("System Bus Data 95:64 (sbdata2)");
+        case 0x3f:
+            return std::string("System Bus Data 127:96 (sbdata3)");
+
+        case 0x40:
+            return std::string("Halt Summary 0 (haltsum0)");
+
+        case 0x70:
+            return std::string("Custom Feature 0 (custom0)");
+        case 0x71:
+             return std::string("Custom Feature 1 (custom1)");
+        case 0x72:
+            return std::string("Custom Feature 2 (custom2)");
+        case 0x73:
+             return std::string("Custom Feature 3 (custom3)");
+        case 0x74:
+            return std::string("Custom Feature 4 (custom4)");
+        case 0x75:
+            return std::string("Custom Feature 5 (custom5)");
+        case 0x76:
+             return std::string("Custom Feature 6 (custom6)");
+        case 0x77:
+            return std::string("Custom Feature 7 (custom7)");
+        case 0x78:
+            return std::string("Custom Feature 8 (custom8)");
+        case 0x79:
+            return std::string("Custom Feature 9 (custom9)");
+        case 0x7a:
+            return std::string("Custom Feature 10 (custom10)");
+        case 0x7b:
+            return std::string("Custom Feature 11 (custom11)");
+        case 0x7c:
+            return std::string("Custom Feature 12 (custom12)");
+        case 0x7d:
+            return std::string("Custom Feature 13 (custom13)");
+        case 0x7e:
+            return std::string("Custom Feature 14 (custom14)");
+        case 0x7f:
+            return std::string("Custom Feature 15 (custom15)");
+
+        default:
+            return std::string("UNKNOWN");
+    }
+}
+
+std::string DebugModule::riscv_register_as_string(uint32_t register_index) {
+
+    // check riscv-openocd source code:
+    //
+    // src/target/riscv/riscv-013.c
+    // uint32_t riscv013_access_register_command(struct target *target, uint32_t number, unsigned size, uint32_t flags)
+    //
+    // subtract the offset of 0x1000 that openocd adds when registers are requested with a value larger than or equal
+    // t0 0x1000. I do not know what the reasoning behind this offset is yet!
+    if (register_index >= 0x1000) {
+        register_index -= 0x1000;
+    }
+
+    switch (register_index) {
+
+        case 0: return "zero";
+        case 1: return "ra";
+        case 2: return "sp";
+        case 3: return "gp";
+        case 4: return "tp";
+        case 5: return "t0";
+        case 6: return "t1";
+        case 7: return "t2";
+        case 8: return "s0/fp";
+        case 9: return "s1";
+        case 10: return "a0";
+        case 11: return "a1";
+        case 12: return "a2";
+        case 13: return "a3";
+        case 14: return "a4";
+        case 15: return "a5";
+        case 16: return "a6";
+        case 17: return "a7";
+        case 18: return "s2";
+        case 19: return "s3";
+        case 20: return "s4";
+        case 21: return "s5";
+        case 22: return "s6";
+        case 23: return "s7";
+        case 24: return "s8";
+        case 25: return "s9";
+        case 26: return "s10";
+        case 27: return "s11";
+        case 28: return "t3";
+        case 29: return "t4";
+        case 30: return "t5";
+        case 31: return "t6";
+
+        // Privileged Machine CSR addresses.
+        // #define CSR_MSTATUS 0x300
+        case 0x0300: return "CSR_MSTATUS 0x0300 (Machine Mode Status Register, ZICSR extension)";
+
+        // Privileged Machine CSR addresses.
+        // #define CSR_MISA 0x301
+        //
+        // Found in riscv-gdb source code: gdb/include/opcode/riscv-opc.h
+        case 0x0301: return "CSR_MISA 0x301 - Machine ISA register (misa) (Machine Mode Status Register, ZICSR extension)";
+
+        // https://drive.google.com/file/d/1joBC2hWGEHJL4tFabjcqMpRqQNkqJ5WR/view
+        // RISC-V Advanced Interrupt Architecture V1.0
+        case 0x035c: return "0x035c Machine top external interrupt (only with an IMSIC) (mtopei)";
+
+        // Number Privilege Width Name Description
+
+        // Machine-Level Window to Indirectly Accessed Registers
+        // 0x350 MRW XLEN miselect Machine indirect register select
+        // 0x351 MRW XLEN mireg Machine indirect register alias
+
+        // Machine-Level Interrupts
+
+        // 0x304 MRW 64 mie Machine interrupt-enable bits
+        // 0x344 MRW 64 mip Machine interrupt-pending bits
+        // 0x35C MRW MXLEN mtopei Machine top external interrupt (only with an
+
+        // IMSIC)
+
+        // 0xFB0 MRO MXLEN mtopi Machine top interrupt
+        // Delegated and Virtual Interrupts for Supervisor Level
+        // 0x303 MRW 64 mideleg Machine interrupt delegation
+        // 0x308 MRW 64 mvien Machine virtual interrupt enables
+        // 0x309 MRW 64 mvip Machine virtual interrupt-pending bits
+
+        // Machine-Level High-Half CSRs (RV32 only)
+
+        // 0x313 MRW 32 midelegh Upper 32 bits of of mideleg (only with S-mode)
+        // 0x314 MRW 32 mieh Upper 32 bits of mie
+        // 0x318 MRW 32 mvienh Upper 32 bits of mvien (only with S-mode)
+        // 0x319 MRW 32 mviph Upper 32 bits of mvip (only with S-mode)
+        // 0x354 MRW 32 miph Upper 32 bits of mip
+
+        //
+        // ZICSR extesnsion
+        //
+
+        // https://www.five-embeddev.com/riscv-priv-isa-manual/latest-adoc/priv-csrs.html
+        // https://xhypervisor.org/pdf/Xvisor_Embedded_Hypervisor_for_RISCV_v5.pdf
+
+        // https://riscv.org/technical/specifications/
+        // https://drive.google.com/file/d/17GeetSnT5wW3xNuAHI95-SI1gPGd5sJ_/view
+
+        // Privileged Hypervisor CSR addresses. from gdb/include/opcode/riscv-opc.h
+        // #define CSR_HSTATUS 0x600
+        // #define CSR_HEDELEG 0x602
+        // #define CSR_HIDELEG 0x603
+        // #define CSR_HIE 0x604
+        // #define CSR_HCOUNTEREN 0x606
+        // #define CSR_HGEIE 0x607
+        // #define CSR_HTVAL 0x643
+        // #define CSR_HIP 0x644
+        // #define CSR_HVIP 0x645
+        // #define CSR_HTINST 0x64a
+        // #define CSR_HGEIP 0xe12
+        // #define CSR_HENVCFG 0x60a
+        // #define CSR_HENVCFGH 0x61a
+        // #define CSR_HGATP 0x680
+        // #define CSR_HTIMEDELTA 0x605
+        // #define CSR_HTIMEDELTAH 0x615
+        case 0x600: return "CSR_HSTATUS"; // hypervisor status register, https://five-embeddev.com/riscv-priv-isa-manual/Priv-v1.12/priv-csrs.html
+        case 0x602: return "CSR_HEDELEG"; // hypervisor exception delegation register
+        case 0x603: return "CSR_HIDELEG"; // hypervisor interrupt delegation register
+        case 0x604: return "CSR_HIE"; // hypervisor interrupt-enable register
+        case 0x606: return "CSR_HCOUNTEREN"; // hypervisor counter enable
+        case 0x607: return "CSR_HGEIE"; // hypervisor guest external interrupt-enable register
+        case 0x643: return "CSR_HTVAL"; // hypervisor bad guest physical address
+        case 0x644: return "CSR_HIP"; // hypervisor interrupt pending
+        case 0x645: return "CSR_HVIP"; // hypervisor virtual interrupt pending
+        case 0x64a: return "CSR_HTINST"; // hypervisor trap instruction (transformed)
+        case 0xe12: return "CSR_HGEIP"; // hypervisor guest external interrupt pending
+        case 0x60a: return "CSR_HENVCFG"; // hypervisor evironment configuration register
+        case 0x61a: return "CSR_HENVCFGH"; // additional hypervisor evironment configuration register (RV32 only)
+        case 0x680: return "CSR_HGATP"; // hypervisor guest translation and protection
+        case 0x605: return "CSR_HTIMEDELTA"; // delta for VS/VU mode timer
+        case 0x615: return "CSR_HTIMEDELTAH"; // upper 32 bit of htimedelta, HSXLEN=32 only
+
+
+
+        // https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf
+        // 5.2.2 Trigger Data 1 (tdata1, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . . . 50
+        // 5.2.3 Trigger Data 2 (tdata2, at 0x7a2) . . . . . . . . . . . . . . . . . . . . . . . . 50
+        // 5.2.4 Trigger Data 3 (tdata3, at 0x7a3) . . . . . . . . . . . . . . . . . . . . . . . . 51
+        // 5.2.5 Trigger Info (tinfo, at 0x7a4) . . . . . . . . . . . . . . . . . . . . . . . . . . 51
+        // 5.2.6 Trigger Control (tcontrol, at 0x7a5) . . . . . . . . . . . . . . . . . . . . . . 51
+        // 5.2.7 Machine Context (mcontext, at 0x7a8) . . . . . . . . . . . . . . . . . . . . . 52
+        // 5.2.8 Supervisor Context (scontext, at 0x7aa) . . . . . . . . . . . . . . . . . . . . 52
+        // 5.2.9 Match Control (mcontrol, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . . 53
+        // 5.2.10 Instruction Count (icount, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . 58
+        // 5.2.11 Interrupt Trigger (itrigger, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . 59
+        // 5.2.12 Exception Trigger (etrigger, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . 60
+        // 5.2.13 Trigger Extra (RV32) (textra32, at 0x7a3) . . . . . . . . . . . . . . . . . . . 60
+        // 5.2.14 Trigger Extra (RV64) (textra64, at 0x7a3) . . . . . . . . . . . . . . . . . . . 61
+
+        case 0x07b0: return "Debug Control and Status (dcsr, at 0x7b0)";
+        case 0x07b1: return "Debug PC (dpc, at 0x7b1)";
+        case 0x07b2: return "Debug Scratch Register 0 (dscratch0, at 0x7b2)";
+        case 0x07b3: return "Debug Scratch Register 1 (dscratch1, at 0x7b3)";
+
+        // Found in riscv-gdb (gdb/include/opcode/riscv-opc.h)
+        // /* Unprivileged Vector CSR addresses.  */
+        // #define CSR_VSTART 0x008
+        // #define CSR_VXSAT 0x009
+        // #define CSR_VXRM 0x00a
+        // #define CSR_VCSR 0x00f
+        // #define CSR_VL 0xc20
+        // #define CSR_VTYPE 0xc21
+        // #define CSR_VLENB 0xc22
+        // 3106d = 0x0C22
+        case 0x0c22: return "SR_VLENB 0xc22";
+
+        // RISC-V Advanced Interrupt Architecture	June 2023	Smaia, Ssaia
+        // https://wiki.riscv.org/display/HOME/Ratified+Extensions
+        //
+        // Machine Level CSRs:
+        //
+        case 0x0fb0: return "0x0fb0 - Machine Top Interrupt (mtopi)";
+
+        // 4104d == 0x1008
+        // Debug: 153 2980 riscv-013.c:703 riscv013_execute_abstract_command(): [riscv.cpu0] access register=0x321008 {regno=0x1008 write=arg0 transfer=enabled postexec=disabled aarpostincrement=disabled aarsize=64bit}
+        case 0x1008: return "s0/fp + gdb offset of 0x1000. I do not know why!";
+
+        default: return "UNKNOWN";
+
+    }
+
+}
@@ -0,0 +1,402 @@
+#ifndef DEBUG_MODULE_H
+#define DEBUG_MODULE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "riscv_assembler/cpu/cpu.h"
+
+// The RISC-V Debug Module (DM). The DTM (remote_bitbang_t) forwards every DMI access to it.
+//
+// Each of the 2^ABITS register addresses has a read and a write handler inside a table that
+// is indexed by the address, so a DMI access costs a single indirect call no matter how many
+// registers the DM implements. Addresses without a register of their own point to handlers
+// that report the access as unknown.
+
+class DebugModule
+{
+
+public:
+
+    // The DMI uses between 7 and 32 address bits.
+    // Each address points at a single 32-bit register that can be read or written.
+    static const uint8_t ABITS_LENGTH = 7;
+    static const uint32_t ABITS_MASK = (1u << ABITS_LENGTH) - 1;
+
+    // hartsel has 20 bits
+    static const uint32_t MAX_HART_COUNT = 1u << 20;
+
+    /// @brief Constructor.
+    /// @param cpu the first hart (hart 0) that is debugged
+    explicit DebugModule(cpu_t* cpu);
+
+    /// @brief Adds a hart behind the ones that exist. The harts share the memory image of hart 0.
+    /// Aborts if there are MAX_HART_COUNT harts already.
+    void add_hart(cpu_t* cpu);
+
+    uint32_t get_hart_count() const;
+
+    /// @brief The hart with the given index, 0 is the hart passed to the constructor.
+    cpu_t* get_hart(uint32_t index);
+
+    /// @brief Sets the register width of the hart, 32 (the default) or 64. Aborts on any other value.
+    /// The emulated core computes with 32 bits, with 64 the DM keeps the upper halves of the GPRs.
+    void set_xlen(uint32_t xlen);
+
+    uint32_t get_xlen() const { return xlen; }
+
+    /// @brief Executes a DMI request.
+    /// @param address the DM register (see register_as_string())
+    /// @param op 1 reads, 2 writes. Every other op (nop) leaves the DM untouched.
+    /// @param data the data of the request, receives the data of the response
+    /// @return the op field of the response. 0 is success, 2 failed, 3 busy.
+    uint8_t execute(uint32_t address, uint8_t op, uint32_t& data);
+
+    /// @brief The name of a DM register for debug output.
+    static std::string register_as_string(uint32_t address);
+
+    /// @brief The ABI name of a register number used by the Access Register command.
+    static std::string riscv_register_as_string(uint32_t register_index);
+
+private:
+
+    // dcsr.cause, the reason the hart has entered Debug Mode
+    static const uint32_t DCSR_CAUSE_EBREAK = 0x01;
+    static const uint32_t DCSR_CAUSE_HALTREQ = 0x03;
+    static const uint32_t DCSR_CAUSE_STEP = 0x04;
+
+    /// @brief Reads the register at address.
+    /// @return the data of the response
+    typedef uint32_t (DebugModule::*read_handler_t)(uint32_t address);
+
+    /// @brief Writes value into the register at address.
+    /// @return the data of the response
+    typedef uint32_t (DebugModule::*write_handler_t)(uint32_t address, uint32_t value);
+
+    struct register_handler_t
+    {
+        read_handler_t read;
+        write_handler_t write;
+    };
+
+    // the state the DM keeps per hart
+    struct hart_t
+    {
+        cpu_t* cpu;
+
+        // The hart comes up halted. While it runs, it executes an instruction per DMI access (see execute()),
+        // a resume request with dcsr.step set executes a single instruction and halts again.
+        bool halted = true;
+
+        // set once the hart has resumed after the last resume request
+        bool resumeack = false;
+
+        // 4.8.1 Debug Control and Status (dcsr, at 0x7b0): the step bit and the reason for the last halt
+        uint32_t dcsr_step = 0x00;
+        uint32_t dcsr_cause = DCSR_CAUSE_HALTREQ;
+
+        // initialize to 0x40000000 simply because I found this post: https://stackoverflow.com/questions/69792036/how-do-i-set-up-data-memory-address-when-using-riscv32-64-unknown-elf-gcc
+        // It explains how to generate a ihex file with gcc without linker script that has it's code section at 0x40000000.
+        // The riscv chip will start execution there
+        uint64_t dpc = 0x40000000;
+
+        // bits 63:32 of the GPRs if xlen is 64. The emulated core only computes the lower halves in cpu->reg.
+        // An upper half is what the debugger has written along with the lower half in reg_lower. Once the
+        // core has changed the lower half, the upper half is stale and the register reads sign-extended.
+        uint32_t reg_upper[32]{0};
+        uint32_t reg_lower[32]{0};
+    };
+
+    struct register_handler_table_t
+    {
+        register_handler_t handlers[1u << ABITS_LENGTH];
+    };
+
+    /// @brief Places the handlers of every implemented register into the table.
+    static register_handler_table_t create_register_handlers();
+
+    // shared by all instances, the handlers are member functions
+    static const register_handler_table_t register_handlers;
+
+    uint32_t read_unknown(uint32_t address);
+    uint32_t write_unknown(uint32_t address, uint32_t value);
+
+    // 0x04 - 0x0f, Abstract Data 0 - 11 (data0 - data11)
+    uint32_t read_data(uint32_t address);
+    uint32_t write_data(uint32_t address, uint32_t value);
+
+    // 0x10, Debug Module Control (dmcontrol)
+    uint32_t read_dmcontrol(uint32_t address);
+    uint32_t write_dmcontrol(uint32_t address, uint32_t value);
+
+    // 0x11, Debug Module Status (dmstatus), read-only
+    uint32_t read_dmstatus(uint32_t address);
+    uint32_t write_dmstatus(uint32_t address, uint32_t value);
+
+    // 0x12, Hart Info (hartinfo), read-only
+    uint32_t read_hartinfo(uint32_t address);
+    uint32_t write_hartinfo(uint32_t address, uint32_t value);
+
+    // 0x40, Halt Summary 0 (haltsum0) and 0x13, Halt Summary 1 (haltsum1), read-only
+    uint32_t read_haltsum(uint32_t address);
+    uint32_t write_haltsum(uint32_t address, uint32_t value);
+
+    // 0x14, Hart Array Window Select (hawindowsel)
+    uint32_t read_hawindowsel(uint32_t address);
+    uint32_t write_hawindowsel(uint32_t address, uint32_t value);
+
+    // 0x15, Hart Array Window (hawindow)
+    uint32_t read_hawindow(uint32_t address);
+    uint32_t write_hawindow(uint32_t address, uint32_t value);
+
+    /// @brief Whether the hart with the given index is selected by hartsel or, with hasel set, by the hart array mask.
+    bool is_selected(uint32_t index);
+
+    /// @brief Points hart at the hart hartsel selects.
+    void select_harts();
+
+    // 0x16, Abstract Control and Status (abstractcs)
+    uint32_t read_abstractcs(uint32_t address);
+    uint32_t write_abstractcs(uint32_t address, uint32_t value);
+
+    // 0x17, Abstract Command (command)
+    uint32_t read_command(uint32_t address);
+    uint32_t write_command(uint32_t address, uint32_t value);
+
+    // 0x18, Abstract Command Autoexec (abstractauto)
+    uint32_t read_abstractauto(uint32_t address);
+    uint32_t write_abstractauto(uint32_t address, uint32_t value);
+
+    // 0x20 - 0x2f, Program Buffer 0 - 15 (progbuf0 - progbuf15)
+    uint32_t read_progbuf(uint32_t address);
+    uint32_t write_progbuf(uint32_t address, uint32_t value);
+
+    // 0x38, System Bus Access Control and Status (sbcs)
+    uint32_t read_sbcs(uint32_t address);
+    uint32_t write_sbcs(uint32_t address, uint32_t value);
+
+    // 0x39 - 0x3a, System Bus Address 31:0 and 63:32 (sbaddress0, sbaddress1)
+    uint32_t read_sbaddress(uint32_t address);
+    uint32_t write_sbaddress(uint32_t address, uint32_t value);
+
+    // 0x3c - 0x3d, System Bus Data 31:0 and 63:32 (sbdata0, sbdata1)
+    uint32_t read_sbdata(uint32_t address);
+    uint32_t write_sbdata(uint32_t address, uint32_t value);
+
+    /// @brief Performs a system bus read of sbaccess size at sbaddress into sbdata, then
+    /// increments sbaddress if sbautoincrement is set. Sets sberror on failure.
+    void system_bus_read();
+
+    /// @brief Performs a system bus write of sbdata, see system_bus_read().
+    void system_bus_write();
+
+    /// @brief Validates a memory access against the memory of the hart.
+    /// @param address the address of the access
+    /// @param size the size of the access in bytes, 1, 2, 4 or 8
+    /// @return 0 if the access is possible, otherwise the sberror code (2 bad address, 3 alignment)
+    uint32_t check_memory_access(uint64_t address, uint32_t size);
+
+    /// @brief Reads size bytes of the hart's memory. The access has to pass check_memory_access().
+    uint64_t read_memory(uint32_t address, uint32_t size);
+
+    /// @brief Writes the size low bytes of value into the hart's memory, see read_memory().
+    void write_memory(uint32_t address, uint32_t size, uint64_t value);
+
+    /// @brief The byte of the hart's memory at address. Creates the (zeroed) segment if the
+    /// memory image has none at address yet.
+    uint8_t* get_memory(uint32_t address);
+
+    /// @brief Packs the fields of dmcontrol into the register value.
+    uint32_t get_dmcontrol();
+
+    /// @brief Executes the abstract command that has last been written into command.
+    /// Does nothing while cmderr is set.
+    void execute_abstract_command();
+
+    /// @brief Executes the Access Register abstract command (cmdtype 0).
+    void access_register(uint32_t control);
+
+    /// @brief Copies a register of the hart into arg0 or arg0 into the register.
+    /// @param regno the register number of the Access Register command
+    /// @param write 1 writes the register, 0 reads it
+    /// @param width the size of the access in bits (aarsize), 32 or 64
+    void transfer_register(uint32_t regno, uint32_t write, uint32_t width);
+
+    /// @brief Reads an argument of an abstract command out of the data registers.
+    /// @param index 0 for arg0, 1 for arg1, ...
+    /// @param width the width of the arguments in bits, 32 or 64
+    uint64_t get_abstract_arg(uint32_t index, uint32_t width);
+
+    /// @brief Writes an argument of an abstract command into the data registers, see get_abstract_arg().
+    void set_abstract_arg(uint32_t index, uint32_t width, uint64_t value);
+
+    /// @brief Runs the program buffer on the hart until it reaches an ebreak. Sets cmderr to 3
+    /// if the hart raises an exception or leaves the program buffer.
+    void execute_program_buffer();
+
+    /// @brief Executes the Quick Access abstract command (cmdtype 1): halts the running hart,
+    /// runs the program buffer and resumes the hart. Sets cmderr to 4 if the hart is halted.
+    void quick_access();
+
+    /// @brief Executes a single instruction on each running hart. Halts the harts that stop.
+    void run_harts();
+
+    /// @brief The hart enters Debug Mode at its current pc.
+    /// @param cause the reason that is reported in dcsr
+    void halt_hart(hart_t& halting, uint32_t cause);
+
+    /// @brief Executes the Access Memory abstract command (cmdtype 2).
+    /// @param command the value written into command
+    void access_memory(uint32_t command);
+
+    std::vector<hart_t> harts;
+
+    // the hart hartsel selects, abstract commands act on it. NULL if hartsel points behind the last hart.
+    hart_t* hart = NULL;
+
+    // the implemented bits of hartsel (HARTSELLEN)
+    uint32_t hartsel_mask = 0x00;
+
+    // 3.14.4 Hart Array Window (hawindow, at 0x15), a bit per hart, 32 harts per window
+    std::vector<uint32_t> hart_array_mask;
+
+    // 3.14.3 Hart Array Window Select (hawindowsel, at 0x14)
+    uint32_t hawindowsel = 0x00;
+
+    // amount of harts that are not halted
+    uint32_t running_hart_count = 0;
+
+    //
+    // these variables all belong to the register 0x10 == DebugModule Control Register (DebugSpec, Page 26 and Page 30)
+    //
+
+    uint32_t haltreq = 0x00; // writing 0 clears the halt request for all currently selected harts. This may cancal outstanding halt requests for those harts.
+    uint32_t resumereq = 0x00;
+    uint32_t hartreset = 0x00;
+    uint32_t ackhavereset = 0x00;
+    uint32_t ackunavail = 0x00;
+    uint32_t hasel = 0x00;
+    uint32_t hartsello = 0x00; // the index of the selected hart (hardware thread), low 10 bits
+    uint32_t hartselhi = 0x00;
+    uint32_t setkeepalive = 0x00;
+    uint32_t clrkeepalive = 0x00;
+    uint32_t setresethaltreq = 0x00;
+    uint32_t clrresethaltreq = 0x00;
+    uint32_t ndmreset = 0x00;
+    uint32_t dmactive = 0x00; // 0x00 module needs reset, 0x01 module functions normally.
+
+    //
+    // these variables all belong to the register 3.14.6. Abstract Control and Status (abstractcs, at 0x16)
+    //
+
+    // Writing this register while an abstract command is executing causes cmderr to become 1 (busy) once
+    // the command completes (busy becomes 0).
+
+    // progbufsize
+    uint32_t progbufsize = 0x10;
+
+    // the program buffer is followed by an implicit ebreak (impebreak in dmstatus)
+    uint32_t impebreak = 0x01;
+
+    uint32_t progbuf[16]{0};
+
+    // 0 (ready): There is no abstract command currently being executed.
+    // 1 (busy): An abstract command is currently being executed
+    uint32_t busy = 0x00;
+
+    // This optional bit controls whether program buffer and
+    // abstract memory accesses are performed with the exact
+    // and full set of permission checks that apply based on the
+    // current architectural state of the hart performing the
+    // access, or with a relaxed set of permission checks (e.g. PMP
+    // restrictions are ignored). The details of the latter are
+    // implementation-specific.
+    // 0 (full checks): Full permission checks apply.
+    // 1 (relaxed checks): Relaxed permission checks apply
+    uint32_t relaxedpriv = 0x00;
+
+    // Gets set if an abstract command fails. The bits in this field
+    // remain set until they are cleared by writing 1 to them. No
+    // abstract command is started until the value is reset to 0.
+    // This field only contains a valid value if busy is 0.
+    // 0 (none): No error.
+    // 1 (busy): An abstract command was executing while
+    // command, abstractcs, or abstractauto was written, or when
+    // one of the data or progbuf registers was read or written.
+    // This status is only written if cmderr contains 0.
+    // 2 (not supported): The command in command is not
+    // supported. It may be supported with different options set,
+    // but it will not be supported at a later time when the hart or
+    // system state are different.
+    // 3 (exception): An exception occurred while executing the
+    // command (e.g. while executing the Program Buffer).
+    // 4 (halt/resume): The abstract command couldn’t execute
+    // because the hart wasn’t in the required state
+    // (running/halted), or unavailable.
+    // 5 (bus): The abstract command failed due to a bus error
+    // (e.g. alignment, access size, or timeout).
+    // 6 (reserved): Reserved for future use.
+    // 7 (other): The command failed for another reason.
+    uint32_t cmderr = 0x00;
+
+    // Number of data registers that are implemented as part of
+    // the abstract command interface. Valid sizes are 1 — 12.
+    // With XLEN 64 Access Memory uses data0-1 for the value and data2-3 for the address.
+    uint32_t datacount = 0x04;
+
+    // the value last written into command (3.14.7. Abstract Command (command, at 0x17))
+    uint32_t command = 0x00;
+
+    //
+    // 3.14.8. Abstract Command Autoexec (abstractauto, at 0x18)
+    //
+
+    // accessing progbuf x executes command again, if bit x is set
+    uint32_t autoexecprogbuf = 0x00;
+
+    // accessing data x executes command again, if bit x is set
+    uint32_t autoexecdata = 0x00;
+
+    //
+    // 3.14.22. System Bus Access Control and Status (sbcs, at 0x38)
+    //
+
+    // set when the debugger accessed an SBA register while the bus was busy. Never happens,
+    // every access completes right away. Cleared by writing 1.
+    uint32_t sbbusyerror = 0x00;
+
+    // a write to sbaddress0 starts a read
+    uint32_t sbreadonaddr = 0x00;
+
+    // 0: 8-bit, 1: 16-bit, 2: 32-bit, 3: 64-bit, 4: 128-bit (not supported)
+    uint32_t sbaccess = 0x02;
+
+    // sbaddress is incremented by the access size after every bus access
+    uint32_t sbautoincrement = 0x00;
+
+    // a read of sbdata0 starts the next read
+    uint32_t sbreadondata = 0x00;
+
+    // 0: none, 1: timeout, 2: bad address, 3: alignment, 4: unsupported size, 7: other.
+    // No bus access is started while it is set. Cleared by writing 1s.
+    uint32_t sberror = 0x00;
+
+    // sbaddress1:sbaddress0
+    uint64_t sbaddress = 0x00;
+
+    // sbdata1:sbdata0
+    uint64_t sbdata = 0x00;
+
+    // the segment get_memory() has found last, most accesses hit the same one
+    uint32_t cached_segment_address = 0x00;
+    uint8_t* cached_segment = NULL;
+
+    uint32_t abstract_data[12]{0};
+
+    // register width of the harts
+    uint32_t xlen = 32;
+
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <string.h>
+#include <cstdio>
+
+#include "jtag_tap.h"
+
+bool parse_jtag_tap_config(const char* text, jtag_tap_config_t& config)
+{
+    const char* separator = strchr(text, ',');
+    size_t role_length = (separator != NULL) ? static_cast<size_t>(separator - text) : strlen(text);
+
+    if ((role_length == 3) && (strncmp(text, "dtm", 3) == 0))
+    {
+        config.role = JtagTapRole::RISCV_DTM;
+        config.ir_length = 5;
+        config.idcode = 0x20000913;
+    }
+    else if ((role_length == 6) && (strncmp(text, "bypass", 6) == 0))
+    {
+        config.role = JtagTapRole::BYPASS_DEVICE;
+        config.ir_length = 4;
+        config.idcode = 0;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (separator == NULL)
+    {
+        return true;
+    }
+
+    char* end;
+    config.ir_length = strtoul(separator + 1, &end, 0);
+    if ((end == separator + 1) || (config.ir_length < 2) || (config.ir_length > 32))
+    {
+        return false;
+    }
+
+    // the DTM's instructions are defined by the RISC-V Debug Specification
+    if ((config.role == JtagTapRole::RISCV_DTM) && (config.ir_length != 5))
+    {
+        return false;
+    }
+
+    if (*end == '\0')
+    {
+        return true;
+    }
+    if (*end != ',')
+    {
+        return false;
+    }
+
+    const char* idcode = end + 1;
+    config.idcode = strtoul(idcode, &end, 0);
+
+    return (end != idcode) && (*end == '\0');
+}
+
+jtag_tap_t::jtag_tap_t(const jtag_tap_config_t& config) : idcode(config.idcode),
+                                                          instruction(IDCODE_INSTRUCTION),
+                                                          instruction_scan_register(config.ir_length)
+{
+    reset();
+}
+
+void jtag_tap_t::reset()
+{
+    // a TAP without IDCODE register comes out of reset with BYPASS selected (IEEE 1149.1)
+    instruction = (idcode != 0) ? IDCODE_INSTRUCTION : ~0U;
+}
+
+void jtag_tap_t::capture_dr()
+{
+    if (instruction == IDCODE_INSTRUCTION)
+    {
+        id_code_scan_register.capture(idcode);
+    }
+}
+
+ScanRegister* jtag_tap_t::get_data_register()
+{
+    if ((instruction == IDCODE_INSTRUCTION) && (idcode != 0))
+    {
+        return &id_code_scan_register;
+    }
+    return NULL;
+}
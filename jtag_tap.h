@@ -0,0 +1,81 @@
+#ifndef JTAG_TAP_H
+#define JTAG_TAP_H
+
+#include <stdint.h>
+
+#include "scan_register.h"
+
+// what a TAP of the scan chain is
+enum class JtagTapRole : uint8_t {
+
+    // the RISC-V Debug Transport Module, implemented by remote_bitbang_t. At most one per chain.
+    RISCV_DTM,
+
+    // any other device of the board. Only implements IDCODE and BYPASS.
+    BYPASS_DEVICE
+
+};
+
+// A TAP of the scan chain as given on the command line (--tap)
+struct jtag_tap_config_t
+{
+    JtagTapRole role;
+
+    // length of the instruction register. The RISC-V DTM always uses 5.
+    uint32_t ir_length;
+
+    // 0 if the TAP has no IDCODE register, BYPASS is selected after reset then
+    uint32_t idcode;
+};
+
+/// @brief Parses a TAP given as <role>[,<irlen>[,<idcode>]], e.g. "dtm", "bypass,4,0x4ba00477".
+/// role is dtm or bypass.
+/// @return false if the text is not a valid TAP
+bool parse_jtag_tap_config(const char* text, jtag_tap_config_t& config);
+
+// A TAP that implements nothing but IDCODE and BYPASS, e.g. a boundary scan device or another
+// core in front of or behind the RISC-V DTM.
+//
+// Its BYPASS register is not part of the class, remote_bitbang_t merges the BYPASS registers of
+// neighboring TAPs into a single scan register so that a scan costs the same for any amount of
+// bypassed TAPs.
+class jtag_tap_t
+{
+
+public:
+
+    // the IDCODE instruction. Every other instruction selects BYPASS.
+    static const uint32_t IDCODE_INSTRUCTION = 0x01;
+
+    explicit jtag_tap_t(const jtag_tap_config_t& config);
+
+    /// @brief Test-Logic-Reset. Selects IDCODE, or BYPASS if there is no IDCODE register.
+    void reset();
+
+    /// @brief Capture-IR. Captures 0b01 as required by IEEE 1149.1.
+    void capture_ir() { instruction_scan_register.capture(0b01); }
+
+    /// @brief Update-IR.
+    void update_ir() { instruction = static_cast<uint32_t>(instruction_scan_register.update()); }
+
+    /// @brief Capture-DR of the selected data register. Nothing to do for BYPASS.
+    void capture_dr();
+
+    ScanRegister* get_instruction_register() { return &instruction_scan_register; }
+
+    /// @brief The selected data register, NULL if BYPASS is selected.
+    ScanRegister* get_data_register();
+
+private:
+
+    uint32_t idcode;
+
+    uint32_t instruction;
+
+    ScanRegister instruction_scan_register;
+
+    ScanRegister id_code_scan_register{32};
+
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include <string.h>
+#include <cstdio>
+
+#include "jtag_vpi.h"
+
+static_assert(sizeof(jtag_vpi_cmd_t) == 4 + 2 * JTAG_VPI_XFERT_MAX_SIZE + 4 + 4, "jtag_vpi message layout must match openocd");
+
+static uint32_t le_to_h_u32(uint32_t value)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+jtag_vpi_t::jtag_vpi_t(uint16_t port, cpu_t* cpu) : remote_bitbang_t(port, cpu)
+{
+}
+
+jtag_vpi_t::jtag_vpi_t(int client_fd, int epoll_fd, cpu_t* cpu) : remote_bitbang_t(client_fd, epoll_fd, cpu)
+{
+}
+
+void jtag_vpi_t::execute_command()
+{
+    if (!begin_batch())
+    {
+        return;
+    }
+
+    // move the incomplete message of the previous read to the front so that the rest of it is appended
+    if (recv_start > 0)
+    {
+        memmove(recv_buf, recv_buf + recv_start, recv_end - recv_start);
+        recv_end -= recv_start;
+        recv_start = 0;
+    }
+
+    if (!receive())
+    {
+        return;
+    }
+
+    // every message produces at most one reply of the same size, so the replies always fit into send_buf
+    jtag_vpi_cmd_t vpi_cmd;
+    while (((recv_end - recv_start) >= static_cast<ssize_t>(sizeof(vpi_cmd))) && !quit)
+    {
+        memcpy(&vpi_cmd, recv_buf + recv_start, sizeof(vpi_cmd));
+        recv_start += sizeof(vpi_cmd);
+
+        execute_vpi_command(vpi_cmd);
+    }
+
+    end_batch();
+}
+
+void jtag_vpi_t::execute_vpi_command(jtag_vpi_cmd_t& vpi_cmd)
+{
+    uint32_t cmd = le_to_h_u32(vpi_cmd.cmd);
+    uint32_t nb_bits = le_to_h_u32(vpi_cmd.nb_bits);
+
+    if (nb_bits > JTAG_VPI_XFERT_MAX_SIZE * 8)
+    {
+        fprintf(stderr, "jtag_vpi message with invalid length: %d bits\n", nb_bits);
+        nb_bits = JTAG_VPI_XFERT_MAX_SIZE * 8;
+    }
+
+    switch (static_cast<JtagVpiCommand>(cmd))
+    {
+
+    case JtagVpiCommand::CMD_RESET:
+        reset(0, 0);
+        break;
+
+    case JtagVpiCommand::CMD_TMS_SEQ:
+        clock_tms_sequence(vpi_cmd.buffer_out, nb_bits);
+        break;
+
+    case JtagVpiCommand::CMD_SCAN_CHAIN:
+    case JtagVpiCommand::CMD_SCAN_CHAIN_FLIP_TMS:
+        clock_scan(vpi_cmd.buffer_out, vpi_cmd.buffer_in, nb_bits,
+            static_cast<JtagVpiCommand>(cmd) == JtagVpiCommand::CMD_SCAN_CHAIN_FLIP_TMS);
+
+        // openocd reads the complete message back, including the header fields
+        memcpy(send_buf + send_end, &vpi_cmd, sizeof(vpi_cmd));
+        send_end += sizeof(vpi_cmd);
+        break;
+
+    case JtagVpiCommand::CMD_STOP_SIMU:
+        quit = 1;
+        break;
+
+    default:
+        fprintf(stderr, "jtag_vpi got unsupported command '%d'\n", cmd);
+        break;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef JTAG_VPI_H
+#define JTAG_VPI_H
+
+#include <stdint.h>
+
+#include "remote_bitbang.h"
+
+// openocd's jtag_vpi adapter (src/jtag/drivers/jtag_vpi.c) sends whole TMS sequences and whole
+// scans per message instead of single pin changes.
+//
+// Every message has the same fixed size. Integers are transferred little endian.
+#define JTAG_VPI_XFERT_MAX_SIZE 512
+
+struct jtag_vpi_cmd_t
+{
+    uint32_t cmd;
+    uint8_t buffer_out[JTAG_VPI_XFERT_MAX_SIZE];
+    uint8_t buffer_in[JTAG_VPI_XFERT_MAX_SIZE];
+    uint32_t length;
+    uint32_t nb_bits;
+};
+
+enum class JtagVpiCommand : uint32_t {
+
+    // TAP reset
+    CMD_RESET = 0,
+
+    // clock the TMS bits of buffer_out into the TAP
+    CMD_TMS_SEQ = 1,
+
+    // shift buffer_out into the TAP, return the shifted out bits in buffer_in
+    CMD_SCAN_CHAIN = 2,
+
+    // same as CMD_SCAN_CHAIN, but TMS is set on the last bit so that the TAP leaves the shift state
+    CMD_SCAN_CHAIN_FLIP_TMS = 3,
+
+    // openocd quits
+    CMD_STOP_SIMU = 4
+
+};
+
+// Serves openocd's jtag_vpi protocol (default port 5555).
+//
+// Drives the same TAP, DTM and DM as the remote bitbang protocol does, but decodes a single
+// message per TMS sequence or scan instead of a single command character per clock edge.
+// Select it inside the openocd cfg with "adapter driver jtag_vpi" (see jtag_vpi.cfg).
+class jtag_vpi_t : public remote_bitbang_t
+{
+
+public:
+
+    /// @brief constructor
+    /// @param port the port for the server to listen on for new connections.
+    /// @param cpu the hart that is debugged.
+    jtag_vpi_t(uint16_t port, cpu_t* cpu);
+
+    /// @brief constructor for a session of the multi-session server.
+    /// @param client_fd the already accepted client connection.
+    /// @param epoll_fd the epoll instance of the worker that serves this session.
+    /// @param cpu the hart that is debugged.
+    jtag_vpi_t(int client_fd, int epoll_fd, cpu_t* cpu);
+
+protected:
+
+    /// @brief Reads all messages the socket has and executes every complete one.
+    /// Incomplete messages stay in recv_buf until the rest of them arrives.
+    virtual void execute_command() override;
+
+private:
+
+    /// @brief Executes a single message. Scans place their reply into the send buffer.
+    void execute_vpi_command(jtag_vpi_cmd_t& vpi_cmd);
+
+};
+
+#endif
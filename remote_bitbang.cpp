@@ -1,8 +1,10 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <netinet/tcp.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cassert>
@@ -10,6 +12,7 @@
 #include <cstdlib>
 
 #include "remote_bitbang.h"
+#include "bitbang_decoder.h"
 
 /// @brief constructor
 /// @param port the port for the server to listen on for new connections.
@@ -17,85 +20,425 @@ remote_bitbang_t::remote_bitbang_t(uint16_t port, cpu_t* cpu) : socket_fd(0),
                                                     client_fd(0),
                                                     recv_start(0),
                                                     recv_end(0),
+                                                    send_start(0),
+                                                    send_end(0),
                                                     err(0),
                                                     tsm_state_machine(this),
+                                                    debug_module(cpu),
                                                     cpu(cpu)
+{
+    init_registers();
+
+    socket_fd = open_listen_socket(port, 1, false);
+
+    // all waiting (for a client to connect, for commands to arrive, for the socket to accept responses)
+    // is done inside epoll_wait() so that an idle server does not use any CPU time
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd == -1)
+    {
+        fprintf(stderr, "remote_bitbang failed to create epoll instance: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = socket_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &event) == -1)
+    {
+        fprintf(stderr, "remote_bitbang failed to watch the listening socket: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+    fprintf(stderr, "This emulator compiled with JTAG Remote Bitbang client. To enable, use +jtag_rbb_enable=1.\n");
+    fprintf(stderr, "Listening on port %d\n", port);
+}
+
+/// @brief constructor for a session that is served by a remote_bitbang_server_t worker.
+/// @param client_fd the already accepted client connection. The session takes ownership.
+/// @param epoll_fd the epoll instance of the worker thread. The client socket is registered with it.
+remote_bitbang_t::remote_bitbang_t(int client_fd, int epoll_fd, cpu_t* cpu) : socket_fd(-1),
+                                                    client_fd(0),
+                                                    epoll_fd(epoll_fd),
+                                                    recv_start(0),
+                                                    recv_end(0),
+                                                    send_start(0),
+                                                    send_end(0),
+                                                    err(0),
+                                                    tsm_state_machine(this),
+                                                    debug_module(cpu),
+                                                    cpu(cpu)
+{
+    init_registers();
+
+    attach_client(client_fd);
+}
+
+remote_bitbang_t::remote_bitbang_t(cpu_t* cpu) : socket_fd(-1),
+                                                    client_fd(0),
+                                                    recv_start(0),
+                                                    recv_end(0),
+                                                    send_start(0),
+                                                    send_end(0),
+                                                    err(0),
+                                                    tsm_state_machine(this),
+                                                    debug_module(cpu),
+                                                    cpu(cpu)
+{
+    init_registers();
+}
+
+remote_bitbang_t::~remote_bitbang_t()
+{
+    if (recorded_commands != NULL)
+    {
+        fclose(recorded_commands);
+        fclose(recorded_responses);
+    }
+
+    for (size_t i = 0; i < taps.size(); i++)
+    {
+        delete taps[i];
+    }
+
+    if (client_fd > 0)
+    {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
+        close(client_fd);
+    }
+
+    // the epoll instance is only owned by a standalone server, sessions share the one of their worker
+    if (socket_fd > 0)
+    {
+        close(socket_fd);
+        close(epoll_fd);
+    }
+}
+
+void remote_bitbang_t::init_registers()
 {
     dtmcs_container_register = init_dtmcs();
     dmi_container_register = init_dmi();
 
-    socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd == -1)
+    jtag_tap_config_t dtm = { JtagTapRole::RISCV_DTM, 5, id_code_container_register };
+    set_tap_chain(std::vector<jtag_tap_config_t>(1, dtm));
+
+    // the other states have nothing to do inside state_entered()
+    tsm_state_machine.set_interested_states(tsm_state_bit(TEST_LOGIC_RESET) |
+        tsm_state_bit(CAPTURE_DR) | tsm_state_bit(CAPTURE_IR) |
+        tsm_state_bit(UPDATE_DR) | tsm_state_bit(UPDATE_IR));
+
+    tck = 1;
+    tms = 1;
+    tdi = 1;
+    trstn = 1;
+    tdo = 0;
+    quit = 0;
+}
+
+void remote_bitbang_t::select_data_register()
+{
+    switch (static_cast<RiscV_DTM_Registers>(instruction_container_register))
+    {
+    case RiscV_DTM_Registers::JTAG_IDCODE:
+        dtm_data_register = &id_code_scan_register;
+        break;
+    case RiscV_DTM_Registers::DTM_CONTROL_AND_STATUS:
+        dtm_data_register = &dtmcs_scan_register;
+        break;
+    case RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS:
+        dtm_data_register = &dmi_scan_register;
+        break;
+    default:
+        dtm_data_register = NULL;
+        break;
+    }
+}
+
+void remote_bitbang_t::start_recording(const char* path)
+{
+    std::string responses_path = std::string(path) + ".tdo";
+
+    recorded_commands = fopen(path, "wb");
+    recorded_responses = fopen(responses_path.c_str(), "wb");
+    if ((recorded_commands == NULL) || (recorded_responses == NULL))
+    {
+        fprintf(stderr, "remote_bitbang failed to create the recording %s: %s (%d)\n", path, strerror(errno), errno);
+        abort();
+    }
+}
+
+void remote_bitbang_t::set_tap_chain(const std::vector<jtag_tap_config_t>& tap_configs)
+{
+    for (size_t i = 0; i < taps.size(); i++)
+    {
+        delete taps[i];
+    }
+    taps.clear();
+    instruction_chain.clear();
+
+    size_t dtm_count = 0;
+    for (size_t i = 0; i < tap_configs.size(); i++)
+    {
+        if (tap_configs[i].role == JtagTapRole::RISCV_DTM)
+        {
+            id_code_container_register = tap_configs[i].idcode;
+            instruction_chain.append(&instruction_scan_register);
+            taps.push_back(NULL);
+            dtm_count++;
+        }
+        else
+        {
+            jtag_tap_t* tap = new jtag_tap_t(tap_configs[i]);
+            instruction_chain.append(tap->get_instruction_register());
+            taps.push_back(tap);
+        }
+    }
+
+    if (dtm_count != 1)
+    {
+        fprintf(stderr, "[Error] the scan chain needs exactly one RISC-V DTM, it has %zu\n", dtm_count);
+        abort();
+    }
+
+    bypass_scan_registers.clear();
+    bypass_scan_registers.reserve(taps.size());
+    selected_data_registers.clear();
+
+    select_data_register();
+    build_data_chain();
+}
+
+void remote_bitbang_t::build_data_chain()
+{
+    bool changed = (selected_data_registers.size() != taps.size());
+    for (size_t i = 0; (i < taps.size()) && !changed; i++)
+    {
+        ScanRegister* selected = (taps[i] != NULL) ? taps[i]->get_data_register() : dtm_data_register;
+        changed = (selected != selected_data_registers[i]);
+    }
+    if (!changed)
+    {
+        return;
+    }
+
+    selected_data_registers.resize(taps.size());
+    for (size_t i = 0; i < taps.size(); i++)
+    {
+        selected_data_registers[i] = (taps[i] != NULL) ? taps[i]->get_data_register() : dtm_data_register;
+    }
+
+    data_chain.clear();
+    bypass_scan_registers.clear();
+
+    size_t i = 0;
+    while (i < taps.size())
+    {
+        if (selected_data_registers[i] != NULL)
+        {
+            data_chain.append(selected_data_registers[i]);
+            i++;
+            continue;
+        }
+
+        size_t first = i;
+        while ((i < taps.size()) && (selected_data_registers[i] == NULL))
+        {
+            i++;
+        }
+        bypass_scan_registers.emplace_back(static_cast<uint32_t>(i - first));
+        data_chain.append(&bypass_scan_registers.back());
+    }
+
+    scan_tdi_bits.resize((data_chain.get_width() + 7) / 8);
+    scan_tdo_bits.resize((data_chain.get_width() + 7) / 8);
+}
+
+int remote_bitbang_t::open_listen_socket(uint16_t port, int backlog, bool reuse_port)
+{
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd == -1)
     {
         fprintf(stderr, "remote_bitbang failed to make socket: %s (%d)\n", strerror(errno), errno);
         abort();
     }
-    fcntl(socket_fd, F_SETFL, O_NONBLOCK);
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);
     int reuseaddr = 1;
-    if (setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &reuseaddr, sizeof(int)) == -1)
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuseaddr, sizeof(int)) == -1)
     {
         fprintf(stderr, "remote_bitbang failed setsockopt: %s (%d)\n", strerror(errno), errno);
         abort();
     }
+    // several sockets bound to the same port, the kernel distributes incoming connections among them
+    int reuseport = 1;
+    if (reuse_port && (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &reuseport, sizeof(int)) == -1))
+    {
+        fprintf(stderr, "remote_bitbang failed setsockopt SO_REUSEPORT: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
     struct sockaddr_in addr;
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(port);
-    if (::bind(socket_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+    if (::bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
     {
         fprintf(stderr, "remote_bitbang failed to bind socket: %s (%d)\n", strerror(errno), errno);
         abort();
     }
-    if (listen(socket_fd, 1) == -1)
+    if (listen(listen_fd, backlog) == -1)
     {
         fprintf(stderr, "remote_bitbang failed to listen on socket: %s (%d)\n", strerror(errno), errno);
         abort();
     }
     socklen_t addrlen = sizeof(addr);
-    if (getsockname(socket_fd, (struct sockaddr *)&addr, &addrlen) == -1)
+    if (getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen) == -1)
     {
         fprintf(stderr, "remote_bitbang getsockname failed: %s (%d)\n", strerror(errno), errno);
         abort();
     }
-    tck = 1;
-    tms = 1;
-    tdi = 1;
-    trstn = 1;
-    quit = 0;
-    fprintf(stderr, "This emulator compiled with JTAG Remote Bitbang client. To enable, use +jtag_rbb_enable=1.\n");
-    fprintf(stderr, "Listening on port %d\n", ntohs(addr.sin_port));
+
+    return listen_fd;
 }
 
 void remote_bitbang_t::accept()
 {
-    int again = 1;
-    while (again != 0)
+    int new_client_fd = ::accept(socket_fd, NULL, NULL);
+    if (new_client_fd == -1)
     {
-        fprintf(stderr, "Attempting to accept client socket\n");
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+        {
+            // no client waiting to connect right now (or it gave up in the meantime).
+            return;
+        }
 
-        client_fd = ::accept(socket_fd, NULL, NULL);
-        if (client_fd == -1)
+        fprintf(stderr, "failed to accept on socket: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+
+    // only a single client is served at a time. Stop watching the listening socket
+    // so that further pending connections do not wake up the event loop.
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket_fd, NULL);
+
+    attach_client(new_client_fd);
+
+    fprintf(stderr, "Accepted successfully\n");
+}
+
+void remote_bitbang_t::attach_client(int new_client_fd)
+{
+    client_fd = new_client_fd;
+
+    fcntl(client_fd, F_SETFL, O_NONBLOCK);
+
+    // responses are already coalesced into batches, send them without waiting for more data
+    int nodelay = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(int));
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = client_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &event) == -1)
+    {
+        fprintf(stderr, "remote_bitbang failed to watch the client socket: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+    client_events = event.events;
+}
+
+void remote_bitbang_t::disconnect_client()
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
+    close(client_fd);
+    client_fd = 0;
+
+    // commands that arrived after the quit request or the disconnect are dropped
+    recv_start = 0;
+    recv_end = 0;
+    send_start = 0;
+    send_end = 0;
+
+    // a standalone server waits for the next client to connect.
+    // A session is released by its worker once the client is gone.
+    if (socket_fd > 0)
+    {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = socket_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &event);
+    }
+}
+
+void remote_bitbang_t::watch_client_writable(bool enable)
+{
+    // while responses are pending, only wait for the socket to become writable. Waiting for
+    // readability at the same time would wake the loop up for input that cannot be decoded yet.
+    watch_client((enable ? EPOLLOUT : EPOLLIN) | EPOLLRDHUP);
+}
+
+void remote_bitbang_t::watch_client(uint32_t events)
+{
+    if (client_events == events)
+    {
+        return;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = client_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client_fd, &event);
+
+    client_events = events;
+}
+
+void remote_bitbang_t::handle_client_event()
+{
+    if (client_fd > 0)
+    {
+        execute_command();
+    }
+}
+
+void remote_bitbang_t::wait_for_events()
+{
+    struct epoll_event events[4];
+
+    int count = epoll_wait(epoll_fd, events, 4, poll_timeout_ms);
+    if (count == -1)
+    {
+        if (errno == EINTR)
         {
-            if (errno == EAGAIN)
+            return;
+        }
+
+        fprintf(stderr, "remote_bitbang epoll_wait failed: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data.fd == socket_fd)
+        {
+            if (client_fd <= 0)
             {
-                // no client waiting to connect right now.
-                fprintf(stderr, "Sleep 600ms\n");
-                std::this_thread::sleep_for(std::chrono::milliseconds(600));
+                this->accept();
             }
-            else
+        }
+        else if (events[i].data.fd == client_fd)
+        {
+            // readable, writable again after backpressure, or hung up. execute_command() sorts it out:
+            // it flushes pending responses first and detects the disconnect when read() returns 0.
+            if (client_fd > 0)
             {
-                fprintf(stderr, "failed to accept on socket: %s (%d)\n", strerror(errno), errno);
-                again = 0;
-                abort();
+                execute_command();
             }
         }
         else
         {
-            fcntl(client_fd, F_SETFL, O_NONBLOCK);
-            again = 0;
-
-            fprintf(stderr, "Accepted successfully\n");
+            // further event sources of the transport have to be served even without a client,
+            // a level-triggered source that stays ready would make epoll_wait() spin
+            handle_event(events[i].data.fd);
         }
     }
 }
@@ -108,22 +451,16 @@ void remote_bitbang_t::tick(
     unsigned char jtag_tdo     // input from the FPGA system into the JTAG module to transfer back to the client
 )
 {
-    if (client_fd > 0)
-    {
-        // should the client send the JTAG bitbang 'R' command, 
-        // then it wants to read the current value of the tdo variable
+    // should the client send the JTAG bitbang 'R' command, 
+    // then it wants to read the current value of the tdo variable
 
-        // Currently do not use the value that the driver (main()) 
-        // program supplies since it currently is not connected to any functioning logic at all.
-        // tdo = jtag_tdo;
+    // Currently do not use the value that the driver (main()) 
+    // program supplies since it currently is not connected to any functioning logic at all.
+    // tdo = jtag_tdo;
 
-        execute_command();
-    }
-    else
-    {
-        fprintf(stderr, "tick() accept()\n");
-        this->accept();
-    }
+    // sleeps until a client connects, sends commands or disconnects. Accepts the
+    // client or executes the commands before returning.
+    wait_for_events();
 
     // write values into the variables that the FPGA simulator can access via VHD
 
@@ -165,8 +502,14 @@ void remote_bitbang_t::set_pins(char _tck, char _tms, char _tdi)
     // on the rising edge, the TAP state machine transitions
     if (_tck != 0) {
 
+        tsm_state previous_state = tsm_state_machine.tsm_current_state;
+
         tsm_state_machine.transition(_tms, static_cast<uint8_t>(_tck));
 
+        if (tsm_state_machine.tsm_current_state == previous_state) {
+            self_loop_cycles[previous_state]++;
+        }
+
     } else {
 
         //fprintf(stderr, "<< %d. ", tdi);
@@ -177,108 +520,129 @@ void remote_bitbang_t::set_pins(char _tck, char _tms, char _tdi)
             // Shift a bit in from TDI (on the rising edge of TCK) and out onto TDO
             // (on the falling edge of TCK) from the currently selected data or instruction register respectively.
             case SHIFT_DR:
-                //fprintf(stderr, "SHIFT_DR entered. rising_edge_clk: %d. ", rising_edge_clk);
-                //fprintf(stderr, "SHIFT_DR entered.\n");
-
-                // shift the data shift register which places the rightmost bit into tdo for subsequent reads to pick up.
-                switch (static_cast<RiscV_DTM_Registers>(instruction_container_register))
-                {
-
-                // DebugSpec, Page 93 - IDCODE register - To identify a specific silicon version.
-                case RiscV_DTM_Registers::JTAG_IDCODE:
-
-                    //fprintf(stderr, "SHIFT_DR entered. rising_edge_clk: %d. SHIFT ", rising_edge_clk);
-
-                    // ignore first shift (dtmcontrol_scan_via_bscan() inside openocd source code: 
-                    // "Note the starting offset is bit 1, not bit 0. In BSCAN tunnel, there is a one-bit TCK skew between output and input")
-                    if (shift_amount >= 1) {
-
-                        // prepare send (which happens on the falling edge of the clock)
-                        // preload the pin with the value that is shifted out from the shift register
-                        tdo = id_code_shift_register & 0x01;
-
-                        // shift data from the tdi register in
-                        id_code_shift_register = id_code_shift_register >> 1;
-
-                        // shift in tdi from the left
-                        id_code_shift_register |= (tdi << (32 - 1)); // size of idcode container register is 32 bits
-
-                    }
-                    shift_amount++;
+                // ignore first shift (see skip_dr_shift)
+                if (skip_dr_shift) {
+                    skip_dr_shift = false;
                     break;
+                }
 
-                // case Instruction::BYPASS:
-                //     fprintf(stderr, "[Error] Unknown instruction register!!! BYPASS\n");
-                //     break;
-
-                // DebugSpec, Page 
-                case RiscV_DTM_Registers::DTM_CONTROL_AND_STATUS:
-                    // fprintf(stderr, "SHIFTING dtcms\n");
+                // shift the selected data register which places the rightmost bit into tdo for subsequent reads to pick up.
+                tdo = data_chain.shift_bit(tdi);
+                if (scan_trace != NULL) {
+                    scan_trace->add_bit(tdi, tdo);
+                }
+                break;
 
-                    // ignore first shift (dtmcontrol_scan_via_bscan()Note the starting offset is bit 1, not bit 0.  In BSCAN tunnel, there is a one-bit TCK skew between output and input)
-                    if (shift_amount >= 1) {
+            // Shift in a bit from tdi into IR (on the rising edge) and also out from the IR to tdi (on the falling edge)
+            case SHIFT_IR:
+                tdo = instruction_chain.shift_bit(tdi);
+                if (scan_trace != NULL) {
+                    scan_trace->add_bit(tdi, tdo);
+                }
+                break;
 
-                        // preload bit to send
-                        tdo = dtmcs_shift_register & 0x01;
+            default:
+                break;
+        }
+    }
+}
 
-                        // shift data from the tdi register in
-                        dtmcs_shift_register = dtmcs_shift_register >> 1;
+void remote_bitbang_t::clock_tms_sequence(const uint8_t* tms_bits, uint32_t nb_bits)
+{
+    // the falling edge in front of every rising edge shifts data while in Shift-DR or Shift-IR
+    const uint32_t shift_states = tsm_state_bit(SHIFT_DR) | tsm_state_bit(SHIFT_IR);
 
-                        // shift in tdi from the left
-                        dtmcs_shift_register |= (tdi << (32 - 1)); // size of dtmcs container register is 32 bits
-                    }
-                    shift_amount++;
-                    break;
+    char bit_tms = 0;
+    uint32_t i = 0;
+    while (i < nb_bits)
+    {
+        // whole bytes that do not pass through a shift state (and do not idle, which is counted) are
+        // resolved 8 edges at a time
+        if ((i + 8) <= nb_bits)
+        {
+            uint8_t tms_byte = tms_bits[i / 8];
+            const tsm_multi_step_t& step = tsm_multi_step_table.steps[tsm_state_machine.tsm_current_state][tms_byte];
+            if ((((tsm_state_bit(tsm_state_machine.tsm_current_state) | step.visited) & shift_states) == 0) &&
+                (step.self_loops == 0))
+            {
+                tsm_state_machine.transition_8(tms_byte);
 
-                case RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS:
-                    //fprintf(stderr, "SHIFTING dmi. tdi: %ld\n", tdi);
+                bit_tms = (tms_byte >> 7) & 0x01;
+                tck = 1;
+                tms = bit_tms;
+                tdi = 0;
 
-                    // ignore first shift (dtmcontrol_scan_via_bscan() Note the starting offset is bit 1, not bit 0.  In BSCAN tunnel, there is a one-bit TCK skew between output and input)
-                    tdo = 0;
-                    if (shift_amount >= 1) {
+                i += 8;
+                continue;
+            }
+        }
 
-                        // // DEBUG
-                        // fprintf(stderr, "DMI Shift Register: ");
-                        // print_dmi(dmi_shift_register);
+        bit_tms = (tms_bits[i / 8] >> (i % 8)) & 0x01;
 
-                        // preload bit to send
-                        tdo = dmi_shift_register & 0x01;
+        set_pins(0, bit_tms, 0);
+        set_pins(1, bit_tms, 0);
+        i++;
+    }
 
-                        // shift data from the tdi register in
-                        dmi_shift_register = dmi_shift_register >> 1;
+    // openocd's bitbang driver leaves every state move with the clock low. The DR shift logic
+    // expects that extra falling edge in front of the first data bit (see skip_dr_shift).
+    if (nb_bits > 0)
+    {
+        set_pins(0, bit_tms, 0);
+    }
+}
 
-                        // shift in tdi from the left
-                        dmi_shift_register |= (tdi << (ABITS_LENGTH + (34 - 1))); // size of dmi container register is variable bits
-                    }
-                    shift_amount++;
-                    break;
+void remote_bitbang_t::clock_scan(const uint8_t* tdi_bits, uint8_t* tdo_bits, uint32_t nb_bits, bool exit_shift)
+{
+    memset(tdo_bits, 0, (nb_bits + 7) / 8);
 
-                default:
-                    fprintf(stderr, "[Error] A Unknown instruction register!!! %d \n", instruction_container_register);
-                    break;
-                }
+    if (nb_bits == 0)
+    {
+        return;
+    }
 
-                break;
+    tsm_state state = tsm_state_machine.tsm_current_state;
+    if ((state == SHIFT_DR) || (state == SHIFT_IR))
+    {
+        ScanChain& scan_chain = (state == SHIFT_DR) ? data_chain : instruction_chain;
 
-            // Shift in a bit from tdi into IR (on the rising edge) and also out from the IR to tdi (on the falling edge)
-            case SHIFT_IR:
-                //fprintf(stderr, "SHIFT_IR entered. rising_edge_clk: %d. \n", rising_edge_clk);
-                //fprintf(stderr, "SHIFT_IR entered\n");
+        uint32_t first = 0;
+        if ((state == SHIFT_DR) && skip_dr_shift)
+        {
+            // the first bit is lost to the skew, tdo keeps its value
+            skip_dr_shift = false;
+            tdo_bits[0] = tdo & 0x01;
+            first = 1;
+        }
 
-                // prepare send (which happens on the falling edge of the clock)
-                // preload the pin with the value that is shifted out from the shift register
-                tdo = instruction_shift_register & 0x01;
+        // all falling edges of the scan shift the same registers, so the bits are shifted a word at a time
+        scan_chain.shift(tdi_bits, tdo_bits, first, nb_bits - first);
+        if (scan_trace != NULL)
+        {
+            scan_trace->add_bits(tdi_bits, tdo_bits, first, nb_bits - first);
+        }
+        tdo = (tdo_bits[(nb_bits - 1) / 8] >> ((nb_bits - 1) % 8)) & 0x01;
 
-                // fprintf(stderr, "Before: tdi: %d instruction_shift_register %d\n", tdi, instruction_shift_register);
+        // every rising edge but the last one stays inside the shift state
+        self_loop_cycles[state] += nb_bits - 1;
 
-                // shift data from the tdi register in
-                instruction_shift_register = instruction_shift_register >> 1;
-                instruction_shift_register |= (tdi << (5 - 1)); // size of ircode container register is 5 bits
+        char last_tms = exit_shift ? 1 : 0;
+        char last_tdi = (tdi_bits[(nb_bits - 1) / 8] >> ((nb_bits - 1) % 8)) & 0x01;
+        set_pins(1, last_tms, last_tdi);
 
-                // fprintf(stderr, "After: tdi: %d instruction_shift_register %d\n", tdi, instruction_shift_register);
+        return;
+    }
 
-            break;
-        }
+    for (uint32_t i = 0; i < nb_bits; i++)
+    {
+        // the last bit leaves the shift state if requested
+        char bit_tms = (exit_shift && (i == nb_bits - 1)) ? 1 : 0;
+        char bit_tdi = (tdi_bits[i / 8] >> (i % 8)) & 0x01;
+
+        // same edges as in the bitbang protocol: falling edge, sample tdo, rising edge
+        set_pins(0, bit_tms, bit_tdi);
+        tdo_bits[i / 8] |= (tdo & 0x01) << (i % 8);
+        set_pins(1, bit_tms, bit_tdi);
     }
 }
 
@@ -286,10 +650,6 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
 {
     // fprintf(stderr, "state_entered\n");
 
-    uint64_t dmi_address = 0x00;
-    uint64_t dmi_data = 0x00;
-    uint64_t dmi_op = 0x00;
-
     switch (new_state)
     {
 
@@ -300,6 +660,16 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
         // TODO: write IDCODE value into DR!
         // see: https://openocd.org/doc/pdf/openocd.pdf#page=69&zoom=100,120,96
         instruction_container_register = static_cast<uint8_t>(RiscV_DTM_Registers::JTAG_IDCODE);
+        select_data_register();
+
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            if (taps[i] != NULL)
+            {
+                taps[i]->reset();
+            }
+        }
+        build_data_chain();
 
         break;
 
@@ -382,34 +752,49 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
         {
 
         case RiscV_DTM_Registers::JTAG_IDCODE:
-            fprintf(stderr, "\nCAPTURE_DR - capturing IDCODE into id_code_shift_register\n");
-            id_code_shift_register = id_code_container_register;
-            shift_amount = 0;
+            fprintf(stderr, "\nCAPTURE_DR - capturing IDCODE into id_code_scan_register\n");
+            id_code_scan_register.capture(id_code_container_register);
             break;
 
-            // TODO case for bypass
-
         case RiscV_DTM_Registers::DTM_CONTROL_AND_STATUS:
-            fprintf(stderr, "\nCAPTURE_DR - RISCV_DTM_REGISTERS::DTM_CONTROL_AND_STATUS - capturing dtmcs_container_register into dtmcs_shift_register - ");
+            fprintf(stderr, "\nCAPTURE_DR - RISCV_DTM_REGISTERS::DTM_CONTROL_AND_STATUS - capturing dtmcs_container_register into dtmcs_scan_register - ");
             print_dtmcs(dtmcs_container_register);
-            dtmcs_shift_register = dtmcs_container_register;
-            shift_amount = 0;
+            dtmcs_scan_register.capture(dtmcs_container_register);
             break;
 
         case RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS:
 #ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
-            fprintf(stderr, "\nCAPTURE_DR - RISCV_DTM_REGISTERS::DEBUG_MODULE_INTERFACE_ACCESS - capturing dmi_container_register into dmi_shift_register - ");
+            fprintf(stderr, "\nCAPTURE_DR - RISCV_DTM_REGISTERS::DEBUG_MODULE_INTERFACE_ACCESS - capturing dmi_container_register into dmi_scan_register - ");
             print_dmi(dmi_container_register);
 #endif
-            dmi_shift_register = dmi_container_register;
-            shift_amount = 0;
+            dmi_scan_register.capture(dmi_container_register);
+            dmi_scan_pending = true;
             break;
 
+        // every other instruction selects BYPASS
         default:
-            fprintf(stderr, "[Error] B Unknown instruction register!!!\n");
             break;
         }
 
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            if (taps[i] != NULL)
+            {
+                taps[i]->capture_dr();
+            }
+        }
+        for (size_t i = 0; i < bypass_scan_registers.size(); i++)
+        {
+            bypass_scan_registers[i].capture(static_cast<uint64_t>(0));
+        }
+
+        skip_dr_shift = true;
+
+        if (scan_trace != NULL)
+        {
+            scan_trace->begin(ScanTraceType::DR_SCAN);
+        }
+
         break;
     case CAPTURE_IR:
         // fprintf(stderr, "CAPTURE_IR entered\n");
@@ -417,7 +802,20 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
         // copy data from the IR container register into the IR shift register.
         // the length of the IR register can be specified via the openocd.cfg file.
         // It is set to 8 in this example.
-        instruction_shift_register = static_cast<uint8_t>(instruction_container_register);
+        instruction_scan_register.capture(instruction_container_register);
+
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            if (taps[i] != NULL)
+            {
+                taps[i]->capture_ir();
+            }
+        }
+
+        if (scan_trace != NULL)
+        {
+            scan_trace->begin(ScanTraceType::IR_SCAN);
+        }
         break;
 
     // Shift a bit in from TDI (on the rising edge of TCK) and out onto TDO
@@ -464,12 +862,18 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
     // or onto the interconnect (for outputs).
     case UPDATE_DR:
         // fprintf(stderr, "UPDATE_DR entered\n");
+        if (scan_trace != NULL)
+        {
+            scan_trace->commit(instruction_container_register);
+        }
+        dr_scan_count++;
+
         switch (static_cast<RiscV_DTM_Registers>(instruction_container_register))
         {
 
         case RiscV_DTM_Registers::JTAG_IDCODE:
             // fprintf(stderr, "UPDATE_DR RiscV_DTM_Registers::JTAG_IDCODE\n");
-            id_code_container_register = id_code_shift_register;
+            id_code_container_register = static_cast<uint32_t>(id_code_scan_register.update());
             break;
 
         case RiscV_DTM_Registers::DTM_CONTROL_AND_STATUS:
@@ -479,7 +883,7 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
             print_dtmcs(dtmcs_container_register);
 
             // DEBUG just activate this line again!
-            //dtmcs_container_register = dtmcs_shift_register;
+            //dtmcs_container_register = static_cast<uint32_t>(dtmcs_scan_register.update());
 
             // print after the change
             print_dtmcs(dtmcs_container_register);
@@ -499,8 +903,8 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
 #endif
 
             // TODO I think this makes no sense
-            if (dmi_shift_register != 0x00) {
-                dmi_container_register = dmi_shift_register;
+            if (dmi_scan_register.update() != 0x00) {
+                dmi_container_register = dmi_scan_register.update();
 
 #ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
                 // print after the change
@@ -508,1024 +912,390 @@ void remote_bitbang_t::state_entered(tsm_state new_state, uint8_t rising_edge_cl
 #endif
             }
 
-            dmi_address = get_dmi_address(dmi_container_register);
-            dmi_data = get_dmi_data(dmi_container_register);
-            dmi_op = get_dmi_op(dmi_container_register);
-
-            // DEBUG
-            //fprintf(stderr, "dmi_address: %ld, dmi_data: %ld, dmi_op: %ld (%s)\n", dmi_address, dmi_data, dmi_op, operation_as_string(dmi_op).c_str());
-
-            // The user accesses the registers inside the DebugModule over the DebugBus which might be
-            // AXI, AMBA, .... First the command to execute a read operation is sent to the DebugModuleInterface (DMI)
-            // which then talks to the DebugModule (DM) over the bus to access a register.
-
-            // 0x04 (Abstract Data 0 (data0))
-            // 0x05 (Abstract Data 1 (data1))
-            // ...
-            // 0x0f (Abstract Data 11 (data11))
-            if ((dmi_address >= 0x04) && (dmi_address <= 0x0f)) {
-            
-                // data 0 through data 11 (Registers data 0 - data 11) are registers that may
-                // be read or changed by abstract commands. datacount indicates how many 
-                // of them are implemented, starting at data0 counting up. 
-                //
-                // Table 2 shows how abstract commands use these registers.
-
-                // // aampostincrement
-                // fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Abstract Data 0 (data0) (0x04) \n");
-                // fprintf(stderr, "\ndmi_data: %ld\n", dmi_data);
-
-                uint32_t idx = dmi_address - 0x04;
-
-                if (dmi_op == 0x01) {
-
-                    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Abstract Data %d (data%d) (0x%02x) READ. value = %ld\n", idx, idx, idx, abstract_data[dmi_address - 0x04]);
-                    dmi_data = abstract_data[idx];
-
-                    // success, the operation 0x00 used in a response is interpreted by openocd
-                    // as a successfull termination of the requested operation
-                    dmi_op = 0x00;
-
-                    // set a value into the dmi_container_register
-                    dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                        ((dmi_data & 0xFFFFFFFF) << 2) | 
-                        ((dmi_op & 0b11) << 0);
-
-                } else if (dmi_op == 0x02) {
-
-                    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Abstract Data %d (data%d) (0x%02x) WRITE \n", idx, idx, idx);
-                    abstract_data[dmi_address - 0x04] = dmi_data;
-
-                }
-
-                //fprintf(stderr, "\ndmi_data: %ld\n", dmi_data);
-
-            }
-            // 0x10 == DebugModule Control Register (DebugSpec, Page 26 and Page 30)
-            else if (dmi_address == 0x10) {
-                
-                // read operation
-                if ((dmi_address == 0x10) && (dmi_op == 0x01)) {
-
-                    fprintf(stderr, "\nDebugModule Control Register READ\n");
-
-                    // construct the response
-                    uint64_t debug_module_control = 
-                        (haltreq << 31) |           // Writing 0 clears the halt request bit for all currently selected harts.
-                        (resumereq << 30) |         // Writing 1 causes the currently selected harts to resume once, if they are halted when the write occurs. 
-                        (hartreset << 29) |
-                        (ackhavereset << 28) |
-                        (ackunavail << 27) |
-                        (hasel << 26) |
-                        (hartsello << 16) |
-                        (hartselhi << 6) |
-                        (setkeepalive << 5) |
-                        (clrkeepalive << 4) |
-                        (setresethaltreq << 3) |
-                        (clrresethaltreq << 2) |
-                        (ndmreset << 1) |
-                        (dmactive << 0);
-
-                    // success, the operation 0x00 used in a response is interpreted by openocd
-                    // as a successfull termination of the requested operation
-                    dmi_op = 0x00;
-
-                    // set a value into the dmi_container_register
-                    dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                        ((debug_module_control & 0xFFFFFFFF) << 2) | 
-                        ((dmi_op & 0b11) << 0);
-
-                    // // DEBUG
-                    // fprintf(stderr, "Outgoing dmi_control_register after READ: ");
-                    // print_dmi(dmi_container_register);
-
-                }  
-                // write operation
-                else if ((dmi_address == 0x10) && (dmi_op == 0x02)) {
-
-                    fprintf(stderr, "\nDebugModule Control Register WRITE\n");
-
-                    // https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf
-                    
-                    // parse the incoming fields
-                    haltreq = ((dmi_data >> 31) & 0b1);             // Writing 0 clears the halt request bit for all currently selected harts.
-                    resumereq = ((dmi_data >> 30) & 0b1);           // Writing 1 causes the currently selected harts to resume once, if they are halted when the write occurs. 
-                    hartreset = ((dmi_data >> 29) & 0b1);           // This optional field writes the reset bit for all the currently selected harts. To perform a reset the debugger writes 1, and then writes 0 to deassert the reset signal.
-                    ackhavereset = ((dmi_data >> 28) & 0b1);
-                    ackunavail = ((dmi_data >> 27) & 0b1);
-                    hasel = ((dmi_data >> 26) & 0b1);
-                    hartsello = ((dmi_data >> 16) & 0b1111111111);
-                    hartselhi = ((dmi_data >> 6) & 0b1111111111);
-                    setkeepalive = ((dmi_data >> 5) & 0b1);
-                    clrkeepalive = ((dmi_data >> 4) & 0b1);
-                    setresethaltreq = ((dmi_data >> 3) & 0b1);
-                    clrresethaltreq = ((dmi_data >> 2) & 0b1);
-                    ndmreset = ((dmi_data >> 1) & 0b1);
-                    dmactive = ((dmi_data >> 0) & 0b1);             // This bit serves as a reset signal for the Debug Module itself. 0 triggers a reset. 1 causes the module to remain as is without reset.
-
-                    fprintf(stderr, "\n");
-                    fprintf(stderr, "haltreq: %d\n", haltreq);
-                    fprintf(stderr, "resumereq: %d\n", resumereq);
-                    fprintf(stderr, "hartreset: %d\n", hartreset);
-                    fprintf(stderr, "ackhavereset: %d\n", ackhavereset);
-                    fprintf(stderr, "ackunavail: %d\n", ackunavail);
-                    fprintf(stderr, "hasel: %d\n", hasel);
-                    fprintf(stderr, "hartsello: %d\n", hartsello);
-                    fprintf(stderr, "hartselhi: %d\n", hartselhi);
-                    fprintf(stderr, "setkeepalive: %d\n", setkeepalive);
-                    fprintf(stderr, "clrkeepalive: %d\n", clrkeepalive);
-                    fprintf(stderr, "setresethaltreq: %d\n", setresethaltreq);
-                    fprintf(stderr, "clrresethaltreq: %d\n", clrresethaltreq);
-                    fprintf(stderr, "ndmreset: %d\n", ndmreset);
-                    fprintf(stderr, "dmactive: %d\n", dmactive);
-
-                    // single step requested
-                    if (resumereq == 1) {
-
-                        auto t = std::time(nullptr);
-                        auto tm = *std::localtime(&t);
-
-                        std::ostringstream oss;
-                        oss << std::put_time(&tm, "%d-%m-%Y %H-%M-%S");
-                        auto str = oss.str();
-
-                        std::cout << str << std::endl;
-
-                        fprintf(stderr, "\n %s [SINGLE_STEP] Selected harts perform single step requested!\n", str.c_str());
-
-                        cpu_step(cpu);
-
-                        dpc = cpu->pc;
-                    }
-
-                    // dm restart requested by writing a 1 into the dmactive bit of the dmcontrol register
-                    if (hasel == 0 && dmactive == 1) {
-
-                        fprintf(stderr, "\nDM activate or remain active (not reset) requested!\n");
-
-                        // simulated restart - seen openocd source code. riscv-013.c, line 1839, "Activating the DM."
-                        // openocd writes a 1 into the DM's dmactive bit to tell the DM to activate.
-                        // openocd then performs a wait loop in which the bit is read. When the dmactive bit is
-                        // eventually read a 1, then openocd continues with the next step.
-                        //
-                        // The next step is to select a hart.
-                        dmactive = 1;
-
-                        // construct the response
-                        uint64_t debug_module_control = 
-                            (haltreq << 31) |
-                            (resumereq << 30) |
-                            (hartreset << 29) |
-                            (ackhavereset << 28) |
-                            (ackunavail << 27) |
-                            (hasel << 26) |
-                            (hartsello << 16) |
-                            (hartselhi << 6) |
-                            (setkeepalive << 5) |
-                            (clrkeepalive << 4) |
-                            (setresethaltreq << 3) |
-                            (clrresethaltreq << 2) |
-                            (ndmreset << 1) |
-                            (dmactive << 0);
-
-                        // success, the operation 0x00 used in a response is interpreted by openocd
-                        // as a successfull termination of the requested operation
-                        dmi_op = 0x00;
-
-                        // set a value into the dmi_container_register
-                        dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                            ((debug_module_control & 0xFFFFFFFF) << 2) | 
-                            ((dmi_op & 0b11) << 0);
-
-                        // // DEBUG
-                        // fprintf(stderr, "Outgoing dmi_control_register after WRITE: ");
-                        // print_dmi(dmi_container_register);
-                    }
-                    else if (hasel == 1) {
-
-                        fprintf(stderr, "\nDM Hart Selection requested!\n");
-
-                        // 0b111111111111111111111000001
-                        //
-                        // 1 - hasel
-                        // 1111111111 - hartsello
-                        // 1111111111 - hartselhi
-                        // 0
-                        // 0
-                        // 0
-                        // 0
-                        // 0
-                        // 1 - dmactive
-
-                        // openocd does not know how many harts exist inside the DM.
-                        // It will therefore perform a probe operation as outlined in the
-                        // RISCV debug specification: page 30, 3.14.2 Debug Module Control (cmcontrol, 0x10)
-                        // "A debugger should discover HARTSELLEN" by writing all ones to hartsel (assuming
-                        // the maximum size) and reading back the value to see which bits were actually set"
-                        //
-                        // hartsel is a name for the combined high and low registers {hartsello, hartselhi}
-                        //
-                        // Every individual bit in hartsel stands for a hart. To check which harts exist,
-                        // openocd writes a 1 into each bit and reads back the result. The RISCV processor
-                        // will return the harts that have actually been selected, writing a 0 in bits for
-                        // harts that do not even exist! That way openocd can discover which harts exist!
-                        //
-                        // Here a system with a single hart is simulated so only a single bit will be 
-                        // return 1 (high), the others are set to 0 (low).
-
-                        // debug module is active
-                        dmactive = 1;
-
-                        // only a single hart exists, set only the very first bit in hartsello
-                        //hartsello = 1;
-                        hartsello = 0;
-                        hartselhi = 0;
-
-                        // construct the response
-                        uint64_t debug_module_control = 
-                            (haltreq << 31) |
-                            (resumereq << 30) |
-                            (hartreset << 29) |
-                            (ackhavereset << 28) |
-                            (ackunavail << 27) |
-                            (hasel << 26) |
-                            (hartsello << 16) |
-                            (hartselhi << 6) |
-                            (setkeepalive << 5) |
-                            (clrkeepalive << 4) |
-                            (setresethaltreq << 3) |
-                            (clrresethaltreq << 2) |
-                            (ndmreset << 1) |
-                            (dmactive << 0);
-
-                        // success, the operation 0x00 used in a response is interpreted by openocd
-                        // as a successfull termination of the requested operation
-                        dmi_op = 0x00;
-
-                        // set a value into the dmi_container_register
-                        dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                            ((debug_module_control & 0xFFFFFFFF) << 2) | 
-                            ((dmi_op & 0b11) << 0);
-
-                    }
-
-                }
-
-            } 
-            // 0x11 == DebugModule Status (dmstatus) (DebugSpec, Page 28) - 3.14.1 Debug Module Status
-            else if (dmi_address == 0x11) {
-
-#ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
-                fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Status Register (0x11) \n");
-
-                // read operation
-                if (dmi_op == 0x01) {
-                    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Status Register (0x11) READ \n");
-                } else if (dmi_op == 0x02) {
-                    fprintf(stderr, "\n~~~~~~~~ DebugModule (DM) Status Register (0x11) WRITE \n");
-                }
-#endif
-
-                uint32_t ndmresetpending = 0x00;
-                uint32_t stickyunavail = 0x00;
-                uint32_t impebreak = 0x00;
-                uint32_t allhavereset = 0x00;
-                uint32_t anyhavereset = 0x00;
-                uint32_t allresumeack = 0x01; // this is checked when performing a single step by openocd (step) command
-                uint32_t anyresumeack = 0x00;
-                uint32_t allnonexistent = 0x00;
-                uint32_t anynonexistent = 0x00;
-                uint32_t allunavail = 0x00;
-                uint32_t anyunavail = 0x00;
-                uint32_t allrunning = 0x00;
-                uint32_t anyrunning = 0x00;
-
-                // set allhalted to true since this is a sensical way to make the openocd source code to return
-                // an OK status for the method riscv013_get_hart_state() in src/target/riscv/riscv-013.c
-                uint32_t allhalted = 0x01;
-                uint32_t anyhalted = 0x00;
-
-                // automatically authenticate the debugger as otherwise openocd goes into failure and outputs
-                // this message: "Debugger is not authenticated to target Debug Module. (dmstatus=0x3). Use `riscv authdata_read` and `riscv authdata_write` commands to authenticate."
-                uint32_t authenticated = 0x01;
-
-                uint32_t authbusy = 0x00;
-                uint32_t hasresethaltreq = 0x00;
-                uint32_t confstrptrvalid = 0x00;
-
-                // into version, enter either 2 or 3 since openocd will err out if not compatible version is returned
-                // openocd for riscv supports the version constants 2 or 3
-                // 2 stands for 0.13 and 3 stands for 1.0
-                // see riscv_examine() in src/target/riscv/riscv.c in the openocd source code.
-                uint32_t version = 0x03;
-            
-                // construct the response
-                uint64_t debug_module_status = 
-                    (ndmresetpending << 24) |
-                    (stickyunavail << 23) |
-                    (impebreak << 22) |
-                    (allhavereset << 19) |
-                    (anyhavereset << 18) |
-                    (allresumeack << 17) |
-                    (anyresumeack << 16) |
-                    (allnonexistent << 15) |
-                    (anynonexistent << 14) |
-                    (allunavail << 13) |
-                    (anyunavail << 12) |
-                    (allrunning << 11) |
-                    (anyrunning << 10) |
-                    (allhalted << 9) |
-                    (anyhalted << 8) |
-                    (authenticated << 7) |
-                    (authbusy << 6) |
-                    (hasresethaltreq << 5) |
-                    (confstrptrvalid << 4) |
-                    (version << 0);
-
-                //status_container_register = debug_module_status;
-
-                // success, the operation 0x00 used in a response is interpreted by openocd
-                // as a successfull termination of the requested operation
-                dmi_op = 0x00;
-
-                // set a value into the dmi_container_register
-                dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                    ((debug_module_status & 0xFFFFFFFF) << 2) | 
-                    ((dmi_op & 0b11) << 0);
-
-                // after this, in the logs of openocd (log level -d4) there should be an output similar to this:
-                // "Debug: 2755 50698 riscv-013.c:411 riscv_log_dmi_scan(): read: dmstatus=0x283 {version=1_0 authenticated=true allhalted=1}"
-            
-            }
-            // 0x12 == DebugModule 0x12 (Hart Info (hartinfo)) (DebugSpec, https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf, Page 28) - 3.14.1 Debug Module Status
-            else if (dmi_address == 0x12) {
-
-                // This register gives information about the hart currently selected by hartsel.
-                // This register is optional. If it is not present it should read all-zero.
-                // If this register is included, the debugger can do more with the Program Buffer by writing programs which explicitly access the data and/or dscratch registers.
-                // This entire register is read-only
-
-                if (dmi_op == 0x01) {
-
-                    // read operation
-
-                    // this register is optional. If it is not present, return all zero
+            execute_dmi_request();
+            break;
 
-                    // success, the operation 0x00 used in a response is interpreted by openocd
-                    // as a successfull termination of the requested operation
-                    dmi_op = 0x00;
+        // BYPASS has nothing to update
+        default:
+            break;
+        }
+        break;
 
-                    // set a value into the dmi_container_register
-                    dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                        ((0x00 & 0xFFFFFFFF) << 2) | 
-                        ((dmi_op & 0b11) << 0);
+    case UPDATE_IR:
+        // fprintf(stderr, "UPDATE_IR entered\n");
+        instruction_container_register = static_cast<uint8_t>(instruction_scan_register.update());
+        select_data_register();
 
-                } else if (dmi_op = 0x02) {
-                    // write operation
-                }
-                
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            if (taps[i] != NULL)
+            {
+                taps[i]->update_ir();
             }
-            // 3.14.6. Abstract Control and Status (abstractcs, at 0x16)
-            else if (dmi_address == 0x16) {
-
-                // read operation
-                if (dmi_op == 0x01) {
-
-                    // construct the response
-                    uint32_t abstractcs_container_register = 
-                        (progbufsize << 24) |
-                        (busy << 12) |
-                        (relaxedpriv << 11) |
-                        (cmderr << 8) |
-                        (datacount << 0);
-
-                    // success, the operation 0x00 used in a response is interpreted by openocd
-                    // as a successfull termination of the requested operation
-                    dmi_op = 0x00;
-
-                    // set a value into the dmi_container_register
-                    dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                        ((abstractcs_container_register & 0xFFFFFFFF) << 2) | 
-                        ((dmi_op & 0b11) << 0);
-
-                    // // DEBUG
-                    // fprintf(stderr, "Outgoing dmi_control_register after READ: ");
-                    // print_dmi(dmi_container_register);
-
-                // write operation
-                } else if (dmi_op == 0x02) {
-
-                    // Writing this register while an abstract command is executing causes cmderr to become 1 (busy) once
-                    // the command completes (busy becomes 0).
-
-                    // progbufsize
-                    //progbufsize = 0x00;
-
-                    // 0 (ready): There is no abstract command currently being executed.
-                    // 1 (busy): An abstract command is currently being executed
-                    //busy = 0x00;
-
-                    // This optional bit controls whether program buffer and
-                    // abstract memory accesses are performed with the exact
-                    // and full set of permission checks that apply based on the
-                    // current architectural state of the hart performing the
-                    // access, or with a relaxed set of permission checks (e.g. PMP
-                    // restrictions are ignored). The details of the latter are
-                    // implementation-specific.
-                    // 0 (full checks): Full permission checks apply.
-                    // 1 (relaxed checks): Relaxed permission checks apply
-                    //relaxedpriv = 0x00;
-
-                    // Gets set if an abstract command fails. The bits in this field
-                    // remain set until they are cleared by writing 1 to them. No
-                    // abstract command is started until the value is reset to 0.
-                    // This field only contains a valid value if busy is 0.
-                    // 0 (none): No error.
-                    // 1 (busy): An abstract command was executing while
-                    // command, abstractcs, or abstractauto was written, or when
-                    // one of the data or progbuf registers was read or written.
-                    // This status is only written if cmderr contains 0.
-                    // 2 (not supported): The command in command is not
-                    // supported. It may be supported with different options set,
-                    // but it will not be supported at a later time when the hart or
-                    // system state are different.
-                    // 3 (exception): An exception occurred while executing the
-                    // command (e.g. while executing the Program Buffer).
-                    // 4 (halt/resume): The abstract command couldn’t execute
-                    // because the hart wasn’t in the required state
-                    // (running/halted), or unavailable.
-                    // 5 (bus): The abstract command failed due to a bus error
-                    // (e.g. alignment, access size, or timeout).
-                    // 6 (reserved): Reserved for future use.
-                    // 7 (other): The command failed for another reason.
-                    //cmderr = 0x00;
-
-                    // Number of data registers that are implemented as part of
-                    // the abstract command interface. Valid sizes are 1 — 12.
-                    //datacount = 0x00;
-
-                    abstractcs_container_register = ((progbufsize & 0b11111) << 24) | 
-                        ((busy & 0b1) << 12) |
-                        ((relaxedpriv & 0b1) << 11) |
-                        ((cmderr & 0b111) << 8) |
-                        ((datacount & 0b1111) << 0);
-
-                }
-
-            } 
-            // 3.14.7. Abstract Command (command, at 0x17)
-            else if (dmi_address == 0x17) {
-
-                // file:///home/wbi/Downloads/riscv-debug-specification.pdf
-
-                // Register 0x17 is first written to start an abstract command to read a register for example.
-                // Register 0x16 is then polled to see if the command has terminated
-                // the resulting value is then read from register 0x04 for 32 bit and from
-                // register 0x04 and 0x05 for 64 bit.
-
-                // cmdtype: 0, control: 3280904
-                uint64_t cmdtype = ((dmi_data >> 24) & 0xFF);
-                uint64_t control = ((dmi_data >> 0) & 0xFFFFFF);
+        }
+        build_data_chain();
 
-                // read operation
-                if (dmi_op == 0x01) {
+        if (scan_trace != NULL)
+        {
+            scan_trace->commit(instruction_container_register);
+        }
+        ir_scan_count++;
+        break;
 
-                    //fprintf(stderr, "\nAbstract Command READ\n");
+    default:
+        fprintf(stderr, "[Error] Unknown state!!!\n");
+        return;
+    }
+}
 
-                    uint32_t regno = (control >> 0) & 0xFFFF;
-                    uint32_t write = (control >> 16) & 0x01;
-                    uint32_t transfer = (control >> 17) & 0x01;
-                    uint32_t postexec = (control >> 18) & 0x01;
-                    uint32_t aarpostincrement = (control >> 19) & 0x01;
-                    uint32_t aarsize = (control >> 20) & 0b111;
+uint8_t remote_bitbang_t::dmi_read(uint32_t address, uint32_t& data)
+{
+    dmi_container_register = ((static_cast<uint64_t>(address) & ABITS_MASK) << 34) | 0x01;
+    execute_dmi_request();
 
-                    // CSR_MISA register
-                    if (regno == 0x301) {
+    data = get_dmi_data(dmi_container_register);
+    return get_dmi_op(dmi_container_register);
+}
 
-                        // Register 0x17 is first written to start an abstract command to read a register for example.
-                        // Register 0x16 is then polled to see if the command has terminated
-                        // the resulting value is then read from register 0x04 for 32 bit and from
-                        // register 0x04 and 0x05 for 64 bit.
+uint8_t remote_bitbang_t::dmi_write(uint32_t address, uint32_t data)
+{
+    dmi_container_register = ((static_cast<uint64_t>(address) & ABITS_MASK) << 34) |
+        (static_cast<uint64_t>(data) << 2) | 0x02;
+    execute_dmi_request();
 
-                        // The misa CSR is a WARL read-write register reporting the ISA supported by the hart. 
-                        // This register must be readable in any implementation, but a value of zero can be 
-                        // returned to indicate the misa register has not been implemented, requiring that CPU 
-                        // capabilities be determined through a separate non-standard mechanism.
+    return get_dmi_op(dmi_container_register);
+}
 
-                        // read operation
-                        fprintf(stderr, "read CSR_MISA (0x301)\n");
+void remote_bitbang_t::execute_dmi_request()
+{
+    uint32_t dmi_address = static_cast<uint32_t>(get_dmi_address(dmi_container_register));
+    uint32_t dmi_data = static_cast<uint32_t>(get_dmi_data(dmi_container_register));
+    uint8_t dmi_op = static_cast<uint8_t>(get_dmi_op(dmi_container_register));
 
-                        //                   MXL   ZYXWVUTSRQPONMLKJIHGFEDCBA
-                        abstract_data[0] = 0b01000000000000000000000100101000;
-        
-                    } else {
+    if ((dmi_op == 0x01) || (dmi_op == 0x02))
+    {
+        dmi_op_count++;
+    }
 
-                        fprintf(stderr, "\n[ERROR] UNKNOWN REGISTER !!!!! RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS ACCESS REGISTER COMMAND read regno: %" PRIu32 " (0x%04x), ABI-Name: %s\n", regno, regno, riscv_register_as_string(regno).c_str());
+    // DEBUG
+    //fprintf(stderr, "dmi_address: %d, dmi_data: %d, dmi_op: %d (%s)\n", dmi_address, dmi_data, dmi_op, operation_as_string(dmi_op).c_str());
 
-                    }
+    // The user accesses the registers inside the DebugModule over the DebugBus which might be
+    // AXI, AMBA, .... First the command to execute a read operation is sent to the DebugModuleInterface (DMI)
+    // which then talks to the DebugModule (DM) over the bus to access a register.
+    dmi_op = debug_module.execute(dmi_address, dmi_op, dmi_data);
 
-                    // The type determines the overall functionality of this abstract command.
-                    //uint32_t cmdtype = 0x00;
+    // The response always carries the op of the DM. Otherwise a subsequent nop (which leaves the
+    // data untouched) would look like the same request once more and execute it again.
+    dmi_container_register = ((static_cast<uint64_t>(dmi_address) & ABITS_MASK) << 34) |
+        (static_cast<uint64_t>(dmi_data) << 2) |
+        (dmi_op & 0b11);
+}
 
-                    // This field is interpreted in a command-specific manner, described for each abstract command.
-                    //uint32_t control = 0x00;
+/// @brief Performs a single Request-Response socket iteration.
+/// 
+/// Each iteration comprises the following steps:
+/// 1. Peform a single read from the socket which fetches as many commands as openocd has sent so far
+/// 2. Decode the whole batch of commands and execute a specific handler for each of them
+/// 3. If a handler wants to return output, write output into socket
+/// 4. If a handler wants to quit the server, quit the server
+void remote_bitbang_t::execute_command()
+{
+    // fprintf(stderr, "execute_command()\n");
 
-                // write operation
-                } else if (dmi_op == 0x02) {
+    if (!begin_batch())
+    {
+        return;
+    }
 
-                    //fprintf(stderr, "\nAbstract Command WRITE\n");
+    // only go back to the kernel once the previous batch has been decoded completely
+    if (recv_start == recv_end)
+    {
+        recv_start = 0;
+        recv_end = 0;
 
-                    // Writes to this register cause the corresponding abstract command to be executed.
-                    //
-                    // Writing this register while an abstract command is executing causes cmderr to 
-                    // become 1 (busy) once the command completes (busy becomes 0).
-                    //
-                    // If cmderr is non-zero, writes to this register are ignored.
-                    //
-                    // cmderr inhibits starting a new command to accommodate debuggers that, for
-                    // performance reasons, send several commands to be executed in a row without checking
-                    // cmderr in between. They can safely do so and check cmderr at the end without worrying
-                    // that one command failed but then a later command (which might have depended on the
-                    // previous one succeeding) passed.
+        if (!receive())
+        {
+            return;
+        }
+    }
 
-                    //cmderr = 0x01;
-                    cmderr = 0x00;
+    // decode the entire batch
+    send_end += process_commands(recv_buf + recv_start, recv_end - recv_start, send_buf + send_end);
+    recv_start = recv_end;
 
-                    // DEBUG
-                    //fprintf(stderr, "\ncmdtype: %d, control: %d\n", cmdtype, control);
+    end_batch();
+}
 
-                    // determine which type of abstract command is executed
-                    if (cmdtype == 0x00) {
+bool remote_bitbang_t::begin_batch()
+{
+    // backpressure: do not decode any new commands while the client has not
+    // accepted all responses of the previous batch yet
+    if (!flush_send_buffer())
+    {
+        if (client_fd > 0)
+        {
+            watch_client_writable(true);
+        }
+        return false;
+    }
 
-                        // 3.7.1.1. Access Register, page 18
-                        //fprintf(stderr, "\nACCESS REGISTER COMMAND\n");
+    // the quit command has been waiting for its responses to be sent
+    if (quit)
+    {
+        if (client_fd > 0)
+        {
+            fprintf(stderr, "Remote end disconnected\n");
+            disconnect_client();
+        }
+        return false;
+    }
 
-                        uint32_t regno = (control >> 0) & 0xFFFF;
-                        uint32_t write = (control >> 16) & 0x01;
-                        uint32_t transfer = (control >> 17) & 0x01;
-                        uint32_t postexec = (control >> 18) & 0x01;
-                        uint32_t aarpostincrement = (control >> 19) & 0x01;
-                        uint32_t aarsize = (control >> 20) & 0b111;
-
-                        // Check if the request has specified the correct register size XLEN.
-                        // If the sent XLEN does not match the real XLEN, the debug interface has
-                        // to set cmderr to 0x02
-                        //
-                        // perform "separate non-standard mechanism" to determine XLEN (register size)
-                        if (aarsize == 2) {
-                            // 32 bit
-                        } else if (aarsize == 3) {
-                            // 64 bit
-
-                            // output error, this system is 32 bit
-
-                            // if any of these operations fail, cmderr is set 
-                            // and none of the remaining steps are executed.
-
-                            // if a command has unsupported options set or if bits that are
-                            // defined as zero are not 0, then the DM must set cmderr to 2 (not supported)
-                            cmderr = 0x02;
-
-                            // // set a value into the dmi_container_register
-                            // dmi_container_register = ((dmi_address & ABITS_MASK) << 34) | 
-                            //     ((abstractcs_container_register & 0xFFFFFFFF) << 2) | 
-                            //     ((dmi_op & 0b11) << 0);
-
-                        } else if (aarsize == 4) {
-                            // 128 bit
-
-                            // output error, this system is 32 bit
-
-                            // if any of these operations fail, cmderr is set 
-                            // and none of the remaining steps are executed.
+    watch_client_writable(false);
 
-                            // if a command has unsupported options set or if bits that are
-                            // defined as zero are not 0, then the DM must set cmderr to 2 (not supported)
-                            cmderr = 0x02;
-                        }
-
-                        fprintf(stderr, "\nACCESS REGISTER COMMAND regno: %" PRIu32 " (0x%04x), ABI-Name: %s\n", regno, regno, riscv_register_as_string(regno).c_str());
-
-                        // try for one of the registers in the register file. GDB will offset them by 0x1000.
-                        uint32_t regno_without_offset = regno - 0x1000;
-                        if ((regno_without_offset >= 0) && (regno_without_offset <= 31)) {
-
-                            fprintf(stderr, "\nACCESS REGISTER COMMAND found register from the register file\n");
-
-                            if (write == 0) {
-
-                                fprintf(stderr, "reading %s\n", riscv_register_as_string(regno_without_offset).c_str());
-
-                                abstract_data[0] = cpu->reg[regno_without_offset];
-
-                            } else if (write == 1) {
-
-                                fprintf(stderr, "write dpc (0x07b1)\n");
-
-                                fprintf(stderr, "write dpc (0x07b1) written control: 0x%08lx\n", control);
-
-                            }
-
-                        } else if (regno == 0x300) {
-
-                            // CSR_MSTATUS register - Zicsr extension
-                            //
-                            // https://book.rvemu.app/hardware-components/03-csrs.html
-                            //
-                            // The status registers, mstatus for M-mode and sstatus for S-mode, 
-                            // keep track of and control the CPU's current operating status.
-                            //
-                            // mstatus is allocated at 0x300 and sstatus is allocated at 0x100. 
-                            // It means we can access status registers by 0x300 and 0x100.
-
-                            // 3.1.6 Machine Status Registers (mstatus and mstatush)
-                            // The mstatus register is an MXLEN-bit read/write register formatted as 
-                            //shown in Figure 1.6 for RV32 and Figure 1.7 for RV64. The mstatus register 
-                            // keeps track of and controls the hart’s current operating state.
-                            //
-                            // A restricted view of mstatus appears as the sstatus register in the S-level ISA.
-
-                            // https://five-embeddev.com/quickref/csrs.html
-
-                            // [31]     SD          - Extension Context - Read-only bit that summarizes whether either the FS, VS or XS fields signal the presence of some dirty state that will require saving extended user context to memory.
-                            // [30-23]  WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
-                            // [22]     TSR         - The TSR (Trap SRET) bit is a WARL field that supports intercepting the supervisor exception return instruction, SRET.
-                            // [21]     TW          - The TW (Timeout Wait) bit is a WARL field that supports intercepting the WFI instruction.
-                            // [20]     TVM         - The TVM (Trap Virtual Memory) bit is a WARL field that supports intercepting supervisor virtual-memory management operations.
-                            // [19]     MXR         - The MXR (Make eXecutable Readable) bit modifies the privilege with which loads access virtual memory. 0 - Only loads from pages marked readable will succeed. 1 - Loads from pages marked either readable or executable will succeed.
-                            // [18]     SUM         - The SUM (permit Supervisor User Memory access) bit modifies the privilege with which S-mode loads and stores access virtual memory. 0 - S-mode memory accesses to pages that are accessible by U-mode will fault. 1. - S-mode memory accesses to pages that are accessible by U-mode are permitted.
-                            // [17]     MPRV        - Modify Privilege
-                            // [16-15]  XS[1:0]     - The XS field encodes the status of additional user-mode extensions and associated state.
-                            // [14-13]  FS[1:0]     - The FS field encodes the status of the floating-point unit state, including the floating-point registers f0–f31 and the CSRs fcsr, frm, and fflags.
-                            // [12-11]  MPP[1:0]    - Machine Previous Privilege mode. Two-level stack
-                            // [10-9]   VS[1:0]     - The VS field encodes the status of the vector extension state, including the vector registers v0–v31 and the CSRs vcsr, vxrm, vxsat, vstart, vl, vtype, and vlenb.
-                            // [8]      SPP         - Supervisor Previous Privilege mode
-                            // [7]      MPIE        - Machine Prior Interrupt Enable
-                            // [6]      UBE         - Endianness Control - Control the endianness of memory accesses made from S-mode other than instruction fetches. (Instruction fetches are always little-endian). 0 - Little Endian. 1 - Big Endian.
-                            // [5]      SPIE        - Supervisor Prior Interrupt Enable
-                            // [4]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
-                            // [3]      MIE         - Machine Interrupt Enable - Global Interupt Enable (in M-Mode) (M-Mode = Machine Mode = application has full access)
-                            // [2]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
-                            // [1]      SIE         - Supervisor Interrupt Enable - Global Interupt Enable (in S-Mode) (S-Mode = Supervisor Mode = application has limited access)
-                            // [0]      WPRI        - Reserved - Writes Preserve Values, Reads Ignore Values (WPRI)
-
-                        } else if (regno == 0x301) {
-
-                            // CSR_MISA register - Zicsr extension
-                            //
-                            // https://book.rvemu.app/hardware-components/03-csrs.html
-                            // https://five-embeddev.com/riscv-priv-isa-manual/Priv-v1.12/machine.html
-                            //
-                            // Register 0x17 is first written to start an abstract command to read a register for example.
-                            // Register 0x16 is then polled to see if the command has terminated
-                            //
-                            // The resulting value is then read from register 0 (0x04) for 32 bit 
-                            // and from register 0 (0x04) and 1 (0x05) for 64 bit.
-
-                            if (write == 0) {
-
-                                fprintf(stderr, "read CSR_MISA (0x301)\n");
-
-                                //                   MXL   ZYXWVUTSRQPONMLKJIHGFEDCBA
-                                abstract_data[0] = 0b01000000000000000000000100101000;
-
-                            } else if (write == 1) {
-
-                                fprintf(stderr, "write CSR_MISA (0x301)\n");
-                            }
-            
-                        } else if (regno == 0x07b0) {
-
-                            // 4.8.1 Debug Control and Status (dcsr, at 0x7b0)
-
-                            // xdebugver [31-28]    0: There is no external debug support. 
-                            //                      4: External debug support exists as it is described in this document. 
-                            //                      15: There is external debug support, but it does not conform to any available version of this spec.
-                            // 0         [27-16]
-                            // ebreakm   [15]       0: ebreak instructions in M-mode behave as described in the Privileged Spec. 
-                            //                      1: ebreak instructions in M-mode enter Debug Mode.
-                            // 0         [14]
-                            // ebreaks   [13]       0: ebreak instructions in S-mode behave as described in the Privileged Spec.
-                            //                      1: ebreak instructions in S-mode enter Debug Mode.
-                            // ebreaku   [12]       0: ebreak instructions in U-mode behave as described in the Privileged Spec.
-                            //                      1: ebreak instructions in U-mode enter Debug Mode.
-                            // stepie    [11]       0: Interrupts are disabled during single stepping.
-                            //                      1: Interrupts are enabled during single stepping.
-                            //                      Implementations may hard wire this bit to 0. In
-                            //                      that case interrupt behavior can be emulated by
-                            //                      the debugger.
-                            //                      The debugger must not change the value of this
-                            //                      bit while the hart is running.
-                            // stopcount [10]       0: Increment counters as usual.
-                            //                      1: Don’t increment any counters while in Debug
-                            //                      Mode or on ebreak instructions that cause entry into Debug Mode.
-                            //                      These counters include the cycle and instret CSRs.
-                            //                      This is preferred for most debugging scenarios.
-                            //                      An implementation may hardwire this bit to 0 or 1.
-                            //                      Stop Counters.
-                            // stoptime  [9]        0: Increment timers as usual.
-                            //                      1: Don’t increment any hart-local timers while in Debug Mode.
-                            //                      An implementation may hardwire this bit to 0 or 1.
-                            //                      Stop timers.
-                            // cause     [8-6]      Explains why Debug Mode was entered.
-                            //                      When there are multiple reasons to enter Debug
-                            //                      Mode in a single cycle, hardware should set cause
-                            //                      to the cause with the highest priority.
-                            //                      1: An ebreak instruction was executed. (priority 3)
-                            //                      2: The Trigger Module caused a breakpoint exception. (priority 4, highest)
-                            //                      3: The debugger requested entry to Debug Mode using haltreq. (priority 1)
-                            //                      4: The hart single stepped because step was set. (priority 0, lowest)
-                            //                      5: The hart halted directly out of reset due to resethaltreq. It is also acceptable to report 3 when
-                            //                      this happens. (priority 2) 
-                            //                      Other values are reserved for future use.
-                            // 0         [5]  
-                            // mprven    [4]        0: MPRV in mstatus is ignored in Debug Mode.
-                            //                      1: MPRV in mstatus takes effect in Debug Mode.
-                            //                      Implementing this bit is optional. It may be tied to either 0 or 1.
-                            // nmip      [3]        When set, there is a Non-Maskable-Interrupt
-                            //                      (NMI) pending for the hart.
-                            //                      Since an NMI can indicate a hardware error condition, reliable debugging may no longer be possible
-                            //                      once this bit becomes set. This is implementationdependent.
-                            // step      [2]        When set and not in Debug Mode, the hart will only execute a single instruction and then enter Debug Mode. 
-                            //                      If the instruction does not complete due to an exception, the hart will immediately enter Debug Mode before executing the trap
-                            //                      handler, with appropriate exception registers set.
-                            //                      The debugger must not change the value of this
-                            //                      bit while the hart is running.
-                            // prv       [1-0]      Contains the privilege level the hart was operating
-                            //                      in when Debug Mode was entered. The encoding
-                            //                      is described in Table 4.5. A debugger can change
-                            //                      this value to change the hart’s privilege level when
-                            //                      exiting Debug Mode.
-                            //                      Not all privilege levels are supported on all harts.
-                            //                      If the encoding written is not supported or the
-                            //                      debugger is not allowed to change to it, the hart
-                            //                      may change to any supported privilege level.
-
-                            if (write == 0) {
-
-                                fprintf(stderr, "read dcsr (0x07b0)\n");
-
-                                uint32_t xdebugver = (control >> 28) & 0b1111;
-                                uint32_t ebreakm = (control >> 15) & 0b1;
-                                uint32_t ebreaks = (control >> 13) & 0b1;
-                                uint32_t ebreaku = (control >> 12) & 0b1;
-                                uint32_t stepie = (control >> 11) & 0b1;
-                                uint32_t stopcount = (control >> 10) & 0b1;
-                                uint32_t stoptime = (control >> 9) & 0b1;
-                                uint32_t cause = (control >> 6) & 0b111;
-                                uint32_t mprven = (control >> 4) & 0b1;
-                                uint32_t nmip = (control >> 3) & 0b1;
-                                uint32_t step = (control >> 2) & 0b1;
-                                uint32_t prv = (control >> 0) & 0b11;
-
-                                fprintf(stderr, "write dcsr (0x07b0) xdebugver: %d\n", xdebugver);
-                                fprintf(stderr, "write dcsr (0x07b0) ebreakm: %d\n", ebreakm);
-                                fprintf(stderr, "write dcsr (0x07b0) ebreaks: %d\n", ebreaks);
-                                fprintf(stderr, "write dcsr (0x07b0) ebreaku: %d\n", ebreaku);
-                                fprintf(stderr, "write dcsr (0x07b0) stepie: %d\n", stepie);
-                                fprintf(stderr, "write dcsr (0x07b0) stopcount: %d\n", stopcount);
-                                fprintf(stderr, "write dcsr (0x07b0) stoptime: %d\n", stoptime);
-                                fprintf(stderr, "write dcsr (0x07b0) cause: %d\n", cause);
-                                fprintf(stderr, "write dcsr (0x07b0) mprven: %d\n", mprven);
-                                fprintf(stderr, "write dcsr (0x07b0) nmip: %d\n", nmip);
-                                fprintf(stderr, "write dcsr (0x07b0) step: %d\n", step);
-                                fprintf(stderr, "write dcsr (0x07b0) prv: %d\n", prv);
-
-                            } else if (write == 1) {
-
-                                fprintf(stderr, "write dcsr (0x07b0)\n");
-
-                                uint32_t xdebugver = 0x04;
-                                uint32_t ebreakm = 0x01;
-                                uint32_t ebreaks = 0x01;
-                                uint32_t ebreaku = 0x01;
-                                uint32_t stepie = 0x00;
-                                uint32_t stopcount = 0x01;
-                                uint32_t stoptime = 0x00;
-                                uint32_t cause = 0x00;
-                                uint32_t mprven = 0x00;
-                                uint32_t nmip = 0x00;
-                                uint32_t step = 0x00;
-                                uint32_t prv = 0x00;
-                            }
-
-                        } else if (regno == 0x07b1) {
-
-                            // 4.8.2 Debug PC (dpc, at 0x7b1)
-                            //
-                            // Upon entry to debug mode, dpc is updated with the virtual address of 
-                            // the next instruction to be executed. The behavior is described in more detail in Table 4.3.
-                            //
-                            // When resuming, the hart’s PC is updated to the virtual address stored in dpc. 
-                            // A debugger may write dpc to change where the hart resumes.
-
-                            if (write == 0) {
-
-                                fprintf(stderr, "read dpc (0x07b1)\n");
-
-                                abstract_data[0] = dpc;
-
-                            } else if (write == 1) {
-
-                                fprintf(stderr, "write dpc (0x07b1)\n");
-
-                                fprintf(stderr, "write dpc (0x07b1) written control: 0x%08lx\n", control);
-
-                            }
-                        
-                        } else {
-
-                            fprintf(stderr, "\n[ERROR] Abstract Command (command, at 0x17) - ACCESS REGISTER COMMAND - UNKNOWN REGISTER !!!!! ACCESS REGISTER COMMAND write regno: %" PRIu32 " (0x%04x), ABI-Name: %s\n", regno, regno, riscv_register_as_string(regno).c_str());
-
-                        }
-                        
-                    } else if (cmdtype == 0x01) {
-
-                        // 3.7.1.2. Quick Access
-                        fprintf(stderr, "\nQUICK_ACCESS\n");
-
-                    } else if (cmdtype == 0x02) {
-
-                        // 3.7.1.3. Access Memory, page 20
-                        //fprintf(stderr, "\nACCESS_MEMORY_COMMAND\n");
-
-                        // This table defines what registers are used for arg0, arg1 and arg2
-                        //
-                        // "Table 2 Use of Data Registers", DebugSpec, page 17
-                        //
-                        // Note: this table seems to be incorrect in the spec! OpenOCD uses the 64 bit
-                        // row for 32 bit width! I'll tell mum...
-                        //
-                        // argument width | arg0 (return) | arg1         | arg2
-                        // 32  (size==2)  | data0         | data1        | data2
-                        // 64  (size==3)  | data0, data1  | data2, data3 | data4, data5
-                        // 128 (size==4)  | data0+1+2+3   | data4+5+6+7  | data8+9+10+11
+    return true;
+}
 
-                        // before this code here is executed, the remote debugger has loaded:
-                        // arg1 into the register 0x06 (Abstract Data 2 (data2))
-                        // arg0 into the register 0x07 (Abstract Data 3 (data3))
-                        //
-                        // if this command is a write command, the requested semantics are
-                        // to write the value stored inside Abstract Data 2 to the memory
-                        // at the address stored in Abstract Data 3
-                        //
-                        // see Debug Spec, page 20 and page21
+bool remote_bitbang_t::receive()
+{
+    ssize_t num_read = read(client_fd, recv_buf + recv_end, buf_size - recv_end);
+    // fprintf(stderr, "num_read %ld\n", num_read);
+    if (num_read == -1)
+    {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+        {
+            // We'll try again the next call.
+            // fprintf(stderr, "Received no command. Will try again on the next call\n");
+            return false;
+        }
+        else if (errno == ECONNRESET)
+        {
+            fprintf(stderr, "Remote end reset the connection\n");
+            disconnect_client();
+            return false;
+        }
+        else
+        {
+            fprintf(stderr, "remote_bitbang failed to read on socket: %s (%d)\n",
+                    strerror(errno), errno);
+            abort();
+        }
+    }
+    else if (num_read == 0)
+    {
+        // The remote disconnected without sending a quit command.
+        fprintf(stderr, "Remote end closed the connection\n");
+        disconnect_client();
+        return false;
+    }
 
-                        uint32_t aamvirtual = ((dmi_data >> 23) & 0b1);
-                        uint32_t aamsize = ((dmi_data >> 20) & 0b111);
-                        uint32_t aampostincrement = ((dmi_data >> 19) & 0b1);
-                        uint32_t write = ((dmi_data >> 16) & 0b1);
-                        uint32_t target_specific = ((dmi_data >> 14) & 0b11);
+    if (recorded_commands != NULL)
+    {
+        fwrite(recv_buf + recv_end, 1, num_read, recorded_commands);
+    }
 
-                        if (write) {
+    recv_end += num_read;
 
-                            if (aamsize == 2) {
+    return true;
+}
 
-                                arg0 = abstract_data[0];
-                                arg1 = abstract_data[1];
+void remote_bitbang_t::end_batch()
+{
+    // the input has run dry (or the batch ended), send all responses of the batch at once
+    bool flushed = flush_send_buffer();
+    if (!flushed && (client_fd > 0))
+    {
+        watch_client_writable(true);
+    }
 
-                            } else if (aamsize == 3) {
+    // quit the server once the responses in front of the quit command have been sent
+    if (quit && flushed && (client_fd > 0))
+    {
+        // The remote disconnected.
+        fprintf(stderr, "Remote end disconnected\n");
+        disconnect_client();
+    }
+}
 
-                                arg0 = abstract_data[0] << 32 | abstract_data[1];
-                                arg1 = abstract_data[2] << 32 | abstract_data[3];
+/// @brief Writes as much of the send buffer into the socket as the socket accepts without blocking.
+/// @return true if the send buffer has been drained completely, false if the socket applied backpressure.
+bool remote_bitbang_t::flush_send_buffer()
+{
+    while (send_start < send_end)
+    {
+        // MSG_NOSIGNAL: a client that went away must not kill the whole process (and all other sessions) with SIGPIPE
+        ssize_t bytes = send(client_fd, send_buf + send_start, send_end - send_start, MSG_NOSIGNAL);
+        if (bytes == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                // the socket is full, keep the remaining responses for the next call
+                return false;
+            }
+            if ((errno == EPIPE) || (errno == ECONNRESET))
+            {
+                fprintf(stderr, "Remote end went away while sending: %s (%d)\n", strerror(errno), errno);
+                disconnect_client();
+                return false;
+            }
 
-                            }
+            fprintf(stderr, "failed to write to socket: %s (%d)\n", strerror(errno), errno);
+            abort();
+        }
 
-                            fprintf(stderr, "ACCESS_MEMORY_COMMAND +++ WRITE 0x%08lx -> 0x%08lx \n", arg0, arg1);
+        if (recorded_responses != NULL)
+        {
+            fwrite(send_buf + send_start, 1, bytes, recorded_responses);
+        }
+        send_start += bytes;
+    }
 
-                        } else {
+    send_start = 0;
+    send_end = 0;
 
-                            if (aamsize == 2) {
+    return true;
+}
 
-                                arg1 = abstract_data[1];
+/// @brief Decodes a single command character and executes the specific handler.
+size_t remote_bitbang_t::process_commands(const char* commands, size_t count, char* responses)
+{
+    size_t response_count = 0;
 
-                            } else if (aamsize == 3) {
+    // decode 64 commands at a time into pin bitplanes, only the other commands go through the switch
+    bitbang_block_t block;
+    size_t offset = 0;
+    while ((offset < count) && !quit)
+    {
+        size_t block_count = std::min<size_t>(64, count - offset);
+        bitbang_decode(commands + offset, block_count, block);
 
-                                arg1 = abstract_data[2] << 32 | abstract_data[3];
+        size_t next_offset = offset + block_count;
+        for (size_t i = 0; (i < block_count) && !quit; i++)
+        {
+            // a DMI scan is applied as a whole. It spans several blocks, decoding continues behind it.
+            if (dmi_scan_pending && !skip_dr_shift && (tsm_state_machine.tsm_current_state == SHIFT_DR))
+            {
+                size_t applied = apply_dmi_scan(commands + offset + i, count - offset - i, responses + response_count);
+                if (applied > 0)
+                {
+                    response_count += data_chain.get_width();
+                    next_offset = offset + i + applied;
+                    break;
+                }
+            }
 
-                            }
+            // idle clocks are applied all at once
+            size_t skipped = skip_stable_state(block, i);
+            if (skipped > 0)
+            {
+                i += skipped - 1;
+                continue;
+            }
 
-                            fprintf(stderr, "ACCESS_MEMORY_COMMAND +++ READ address: 0x%08lx \n", arg1);
+            if ((block.pins >> i) & 0x01)
+            {
+                set_pins((block.tck >> i) & 0x01, (block.tms >> i) & 0x01, (block.tdi >> i) & 0x01);
+            }
+            else if (execute_single_command(commands[offset + i], responses[response_count]))
+            {
+                response_count++;
+            }
+        }
 
-                            // the memory value at the read address is requested from data[0]
-                            //abstract_data[0] = 0xCAFEBABE;
+        offset = next_offset;
+    }
 
-                            uint32_t segment_address = arg1 & 0xFFFF0000;
-                            uint32_t instr_address = arg1 & 0x0000FFFF;
+    return response_count;
+}
 
-                            // check if the segment is created already otherwise create it
-                            std::map<uint32_t, uint32_t *>::iterator it = cpu->segments->find(segment_address);
-                            if (it == cpu->segments->end()) {
-                                uint32_t* segment_ptr = new uint32_t[16384];
-                                cpu->segments->insert(std::pair<uint32_t, uint32_t*>(segment_address, segment_ptr));
-                            }
+size_t remote_bitbang_t::apply_dmi_scan(const char* commands, size_t count, char* responses)
+{
+    // only tried once per scan, whatever the outcome
+    dmi_scan_pending = false;
 
-                            abstract_data[0] = cpu->segments->at(segment_address)[instr_address/4];
+    uint32_t width = data_chain.get_width();
+    size_t length = 3 * static_cast<size_t>(width);
+    if (count < length)
+    {
+        return 0;
+    }
 
-                        }
+    // Every bit is a falling edge, a read and a rising edge with the same tms and tdi. tms is
+    // 0 except for the last bit, which leaves Shift-DR. Anything else takes the edge-level path.
+    uint8_t* tdi_bits = scan_tdi_bits.data();
+    memset(tdi_bits, 0, scan_tdi_bits.size());
+    for (uint32_t bit = 0; bit < width; bit++)
+    {
+        const char* command = commands + 3 * bit;
+        char bit_tms = (bit == width - 1) ? 1 : 0;
 
-                        // if aampostincrement is set, increment arg1
-                        // arg1 for 32bit is: the data 1 register (0x05)
-                        if (aampostincrement) {
+        // the falling edge is '0' - '3' (tck 0), the rising edge the same tms and tdi with tck 1
+        char falling = command[0];
+        if ((falling < '0') || (falling > '3') || (((falling - '0') >> 1) != bit_tms) || (command[1] != 'R') || (command[2] != falling + 4))
+        {
+            return 0;
+        }
 
-                            // to implement correct auto-increment, write the next
-                            // (incremented) address to dmi_data and from dmi_data
-                            // into abstract_data[1]
-                            dmi_data = arg1; 
-                            dmi_data += (2 << (aamsize-1));
+        tdi_bits[bit / 8] |= ((falling - '0') & 0x01) << (bit % 8);
+    }
 
-                        }
+    uint8_t* tdo_bits = scan_tdo_bits.data();
+    data_chain.shift(tdi_bits, tdo_bits, 0, width);
+    if (scan_trace != NULL)
+    {
+        scan_trace->add_bits(tdi_bits, tdo_bits, 0, width);
+    }
+    for (uint32_t bit = 0; bit < width; bit++)
+    {
+        responses[bit] = ((tdo_bits[bit / 8] >> (bit % 8)) & 0x01) ? '1' : '0';
+    }
 
-                        // to implement correct auto-increment (aampostincrement), write the next
-                        // (incremented) address to dmi_data and from dmi_data
-                        // into abstract_data[1]
-                        //
-                        // abstract_data[1] is returned when data1 (abstract_data[1])
-                        // is read. 
-                        //
-                        // When the external debugger retrieves an incremented
-                        // address, it knows that the auto-increment (aampostincrement) feature
-                        // is implemented
-                        abstract_data[1] = dmi_data;
+    // every rising edge but the last one stays inside Shift-DR
+    self_loop_cycles[SHIFT_DR] += width - 1;
 
-                        
-                        
-                    }
+    // the last rising edge goes to Exit1-DR, Update-DR then executes the request as usual
+    tdo = (tdo_bits[(width - 1) / 8] >> ((width - 1) % 8)) & 0x01;
+    set_pins(1, 1, (tdi_bits[(width - 1) / 8] >> ((width - 1) % 8)) & 0x01);
 
-                }
-            
-            } else {
+    return length;
+}
 
-                fprintf(stderr, "\nUPDATE_DR RiscV_DTM_Registers::DEBUG_MODULE_INTERFACE_ACCESS -- [ERROR] UNKNOWN dmi_address!!! 0x%02lx (%s) \n", dmi_address, dm_register_as_string(dmi_address).c_str());
+size_t remote_bitbang_t::skip_stable_state(const bitbang_block_t& block, size_t first)
+{
+    tsm_state state = tsm_state_machine.tsm_current_state;
+    if ((tsm_state_bit(state) & stable_states) == 0)
+    {
+        return 0;
+    }
 
-            }
-            break;
+    // Pin commands that keep the TAP where it is. The falling edges do nothing outside of the shift states
+    // and the rising edges re-enter the state, which state_entered() has nothing to do for (re-entering
+    // Test-Logic-Reset selects IDCODE again, which it already is).
+    uint64_t loop = block.pins & ((state == TEST_LOGIC_RESET) ? block.tms : ~block.tms);
+    uint64_t not_loop = ~(loop >> first);
+    size_t length = (not_loop == 0) ? (64 - first) : __builtin_ctzll(not_loop);
+    if (length == 0)
+    {
+        return 0;
+    }
 
-        default:
-            fprintf(stderr, "[Error] C Unknown instruction register!!!\n");
-            break;
-        }
-        break;
+    uint64_t run = (length == 64) ? ~0ULL : ((1ULL << length) - 1);
+    self_loop_cycles[state] += __builtin_popcountll((block.tck >> first) & run);
 
-    case UPDATE_IR:
-        // fprintf(stderr, "UPDATE_IR entered\n");
-        instruction_container_register = instruction_shift_register;
-        break;
+    size_t last = first + length - 1;
+    tck = (block.tck >> last) & 0x01;
+    tms = (block.tms >> last) & 0x01;
+    tdi = (block.tdi >> last) & 0x01;
 
-    default:
-        fprintf(stderr, "[Error] Unknown state!!!\n");
-        return;
-    }
+    return length;
 }
 
-/// @brief Performs a single Request-Response socket iteration.
-/// 
-/// Each iteration comprises the following steps:
-/// 1. Peform read from socket for openocd input
-/// 2. Determine which command arrived and execute a specific handler
-/// 3. If the handler wants to return output, write output into socket
-/// 4. If the handler wants to quit the server, quit the server
-void remote_bitbang_t::execute_command()
+bool remote_bitbang_t::execute_single_command(char command, char& response)
 {
-    // fprintf(stderr, "execute_command()\n");
-
-    char command;
-    int again = 1;
-    while (again)
-    {
-        ssize_t num_read = read(client_fd, &command, sizeof(command));
-        // fprintf(stderr, "num_read %ld\n", num_read);
-        if (num_read == -1)
-        {
-            if (errno == EAGAIN)
-            {
-                // We'll try again the next call.
-                // fprintf(stderr, "Received no command. Will try again on the next call\n");
-                //fprintf(stderr, "Sleep 10ms\n");
-                //std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            else
-            {
-                fprintf(stderr, "remote_bitbang failed to read on socket: %s (%d)\n",
-                        strerror(errno), errno);
-                again = 0;
-                abort();
-            }
-        }
-        else if (num_read == 0)
-        {
-            fprintf(stderr, "No command received\n");
-            again = 1;
-
-            fprintf(stderr, "sleep 1000\n");
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        }
-        else
-        {
-            again = 0;
-        }
-    }
-
     // fprintf(stderr, "Received a command %c\n", command);
     //fprintf(stderr, "%c ", command);
 
@@ -1629,43 +1399,25 @@ void remote_bitbang_t::execute_command()
         fprintf(stderr, "remote_bitbang got unsupported command '%c'\n", command);
     }
 
-    // this is where the server answers to the client
+    // this is where the server answers to the client. The response is only handed to the caller,
+    // the caller sends the responses of a whole batch of commands at once.
     if (dosend)
     {
-        while (1)
-        {
 
 #ifdef OPENOCD_POLLING_DEBUG // openocd keeps polling the target every 400ms which results in massive spam
-            // // 48d == 0x30 == '0', 49 == 0x31 == '1'
-            // //fprintf(stderr, "Sending %d\n", tosend);
-            if (tosend == 0x30) {
-                fprintf(stderr, "0 ");
-            } else {
-                 fprintf(stderr, "1 ");
-            }
+        // // 48d == 0x30 == '0', 49 == 0x31 == '1'
+        // //fprintf(stderr, "Sending %d\n", tosend);
+        if (tosend == 0x30) {
+            fprintf(stderr, "0 ");
+        } else {
+             fprintf(stderr, "1 ");
+        }
 #endif
 
-            ssize_t bytes = write(client_fd, &tosend, sizeof(tosend));
-            if (bytes == -1)
-            {
-                fprintf(stderr, "failed to write to socket: %s (%d)\n", strerror(errno), errno);
-                abort();
-            }
-            if (bytes > 0)
-            {
-                break;
-            }
-        }
+        response = tosend;
     }
 
-    // quit the server
-    if (quit)
-    {
-        // The remote disconnected.
-        fprintf(stderr, "Remote end disconnected\n");
-        close(client_fd);
-        client_fd = 0;
-    }
+    return dosend;
 }
 
 void remote_bitbang_t::print_dtmcs(uint32_t dtmcs) {
@@ -1851,356 +1603,3 @@ std::string remote_bitbang_t::operation_as_string(uint64_t dmi_op) {
             return std::string("UNKNOWN");
     }
 }
-
-std::string remote_bitbang_t::dm_register_as_string(uint32_t address) {
-    switch (address) {
-
-        case 0x04: 
-            return std::string("Abstract Data 0 (data0)");
-        case 0x05:
-            return std::string("Abstract Data 1 (data1)");
-        case 0x06:
-            return std::string("Abstract Data 2 (data2)");
-        case 0x07:
-            return std::string("Abstract Data 3 (data3)");
-        case 0x08:
-            return std::string("Abstract Data 4 (data4)");
-        case 0x09:
-            return std::string("Abstract Data 5 (data5)");
-        case 0x0a:
-            return std::string("Abstract Data 6 (data6)");
-        case 0x0b:
-            return std::string("Abstract Data 7 (data7)");
-        case 0x0c:
-            return std::string("Abstract Data 8 (data8)");
-        case 0x0d:
-            return std::string("Abstract Data 9 (data9)");
-        case 0x0e:
-            return std::string("Abstract Data 10 (data10)");
-        case 0x0f:
-            return std::string("Abstract Data 11 (data11)");
-
-        case 0x10:
-            return std::string("Debug Module Control (dmcontrol)");
-        case 0x11:
-            return std::string("Debug Module Status (dmstatus)");
-        case 0x12:
-            return std::string("Hart Info (hartinfo)");
-        case 0x13:
-            return std::string("Halt Summary 1 (haltsum1)");
-        case 0x14:
-            return std::string("Hart Array Window Select (hawindowsel)");
-        case 0x15:
-            return std::string("Hart Array Window (hawindow)");
-        case 0x16:
-            return std::string("Abstract Control and Status (abstractcs)");
-        case 0x17:
-            return std::string("Abstract Command (command)");
-        case 0x18:
-            return std::string("Abstract Command Autoexec (abstractauto)");
-        case 0x19:
-            return std::string("Configuration Structure Pointer 0 (confstrptr0)");
-        case 0x1a:
-            return std::string("Configuration Structure Pointer 1 (confstrptr1)");
-        case 0x1b:
-            return std::string("Configuration Structure Pointer 2 (confstrptr2)");
-        case 0x1c:
-            return std::string("Configuration Structure Pointer 3 (confstrptr3)");
-        case 0x1d:
-            return std::string("Next Debug Module (nextdm)");
-        //case 0x1e:
-        //    return std::string("");
-        case 0x1f:
-            return std::string("Custom Features (custom)");
-
-        case 0x20:
-            return std::string("Program Buffer 0 (progbuf0)");
-        case 0x21:
-            return std::string("Program Buffer 1 (progbuf1)");
-        case 0x22:
-            return std::string("Program Buffer 2 (progbuf2)");
-        case 0x23:
-            return std::string("Program Buffer 3 (progbuf3)");
-        case 0x24:
-            return std::string("Program Buffer 4 (progbuf4)");
-        case 0x25:
-            return std::string("Program Buffer 5 (progbuf5)");
-        case 0x26:
-            return std::string("Program Buffer 6 (progbuf6)");
-        case 0x27:
-            return std::string("Program Buffer 7 (progbuf7)");
-        case 0x28:
-            return std::string("Program Buffer 8 (progbuf8)");
-        case 0x29:
-            return std::string("Program Buffer 9 (progbuf9)");
-        case 0x2a:
-            return std::string("Program Buffer 10 (progbuf10)");
-        case 0x2b:
-            return std::string("Program Buffer 11 (progbuf11)");
-        case 0x2c:
-            return std::string("Program Buffer 12 (progbuf12)");
-        case 0x2d:
-            return std::string("Program Buffer 13 (progbuf13)");
-        case 0x2e:
-            return std::string("Program Buffer 14 (progbuf14)");
-        case 0x2f:
-            return std::string("Program Buffer 15 (progbuf15)");
-
-        case 0x30:
-            return std::string("Authentication Data (authdata)");
-        // case 0x31:
-        //     return std::string("");
-        case 0x32:
-            return std::string("Debug Module Control and Status 2 (dmcs2)");
-        // case 0x33:
-        //     return std::string("");
-        case 0x34:
-            return std::string("Halt Summary 2 (haltsum2)");
-        case 0x35:
-            return std::string("Halt Summary 3 (haltsum3)");
-        // case 0x36:
-        //     return std::string("");
-        case 0x37:
-            return std::string("System Bus Address 127:96 (sbaddress3)");
-        case 0x38:
-            return std::string("System Bus Access Control and Status (sbcs)");
-        case 0x39:
-            return std::string("System Bus Address 31:0 (sbaddress0)");
-        case 0x3a:
-            return std::string("System Bus Address 63:32 (sbaddress1)");
-        case 0x3b:
-            return std::string("System Bus Address 95:64 (sbaddress2)");
-        case 0x3c:
-            return std::string("System Bus Data 31:0 (sbdata0)");
-        case 0x3d:
-            return std::string("System Bus Data 63:32 (sbdata1)");
-        case 0x3e:
-            return std::string("System Bus Data 95:64 (sbdata2)");
-        case 0x3f:
-            return std::string("System Bus Data 127:96 (sbdata3)");
-
-        case 0x40:
-            return std::string("Halt Summary 0 (haltsum0)");
-
-        case 0x70:
-            return std::string("Custom Feature 0 (custom0)");
-        case 0x71:
-             return std::string("Custom Feature 1 (custom1)");
-        case 0x72:
-            return std::string("Custom Feature 2 (custom2)");
-        case 0x73:
-             return std::string("Custom Feature 3 (custom3)");
-        case 0x74:
-            return std::string("Custom Feature 4 (custom4)");
-        case 0x75:
-            return std::string("Custom Feature 5 (custom5)");
-        case 0x76:
-             return std::string("Custom Feature 6 (custom6)");
-        case 0x77:
-            return std::string("Custom Feature 7 (custom7)");
-        case 0x78:
-            return std::string("Custom Feature 8 (custom8)");
-        case 0x79:
-            return std::string("Custom Feature 9 (custom9)");
-        case 0x7a:
-            return std::string("Custom Feature 10 (custom10)");
-        case 0x7b:
-            return std::string("Custom Feature 11 (custom11)");
-        case 0x7c:
-            return std::string("Custom Feature 12 (custom12)");
-        case 0x7d:
-            return std::string("Custom Feature 13 (custom13)");
-        case 0x7e:
-            return std::string("Custom Feature 14 (custom14)");
-        case 0x7f:
-            return std::string("Custom Feature 15 (custom15)");
-
-        default:
-            return std::string("UNKNOWN");
-    }
-}
-
-std::string remote_bitbang_t::riscv_register_as_string(uint32_t register_index) {
-
-    // check riscv-openocd source code:
-    //
-    // src/target/riscv/riscv-013.c
-    // uint32_t riscv013_access_register_command(struct target *target, uint32_t number, unsigned size, uint32_t flags)
-    //
-    // subtract the offset of 0x1000 that openocd adds when registers are requested with a value larger than or equal
-    // t0 0x1000. I do not know what the reasoning behind this offset is yet!
-    if (register_index >= 0x1000) {
-        register_index -= 0x1000;
-    }
-
-    switch (register_index) {
-
-        case 0: return "zero";
-        case 1: return "ra";
-        case 2: return "sp";
-        case 3: return "gp";
-        case 4: return "tp";
-        case 5: return "t0";
-        case 6: return "t1";
-        case 7: return "t2";
-        case 8: return "s0/fp";
-        case 9: return "s1";
-        case 10: return "a0";
-        case 11: return "a1";
-        case 12: return "a2";
-        case 13: return "a3";
-        case 14: return "a4";
-        case 15: return "a5";
-        case 16: return "a6";
-        case 17: return "a7";
-        case 18: return "s2";
-        case 19: return "s3";
-        case 20: return "s4";
-        case 21: return "s5";
-        case 22: return "s6";
-        case 23: return "s7";
-        case 24: return "s8";
-        case 25: return "s9";
-        case 26: return "s10";
-        case 27: return "s11";
-        case 28: return "t3";
-        case 29: return "t4";
-        case 30: return "t5";
-        case 31: return "t6";
-
-        // Privileged Machine CSR addresses.
-        // #define CSR_MSTATUS 0x300
-        case 0x0300: return "CSR_MSTATUS 0x0300 (Machine Mode Status Register, ZICSR extension)";
-
-        // Privileged Machine CSR addresses.
-        // #define CSR_MISA 0x301
-        //
-        // Found in riscv-gdb source code: gdb/include/opcode/riscv-opc.h
-        case 0x0301: return "CSR_MISA 0x301 - Machine ISA register (misa) (Machine Mode Status Register, ZICSR extension)";
-
-        // https://drive.google.com/file/d/1joBC2hWGEHJL4tFabjcqMpRqQNkqJ5WR/view
-        // RISC-V Advanced Interrupt Architecture V1.0
-        case 0x035c: return "0x035c Machine top external interrupt (only with an IMSIC) (mtopei)";
-
-        // Number Privilege Width Name Description
-
-        // Machine-Level Window to Indirectly Accessed Registers
-        // 0x350 MRW XLEN miselect Machine indirect register select
-        // 0x351 MRW XLEN mireg Machine indirect register alias
-
-        // Machine-Level Interrupts
-
-        // 0x304 MRW 64 mie Machine interrupt-enable bits
-        // 0x344 MRW 64 mip Machine interrupt-pending bits
-        // 0x35C MRW MXLEN mtopei Machine top external interrupt (only with an
-
-        // IMSIC)
-
-        // 0xFB0 MRO MXLEN mtopi Machine top interrupt
-        // Delegated and Virtual Interrupts for Supervisor Level
-        // 0x303 MRW 64 mideleg Machine interrupt delegation
-        // 0x308 MRW 64 mvien Machine virtual interrupt enables
-        // 0x309 MRW 64 mvip Machine virtual interrupt-pending bits
-
-        // Machine-Level High-Half CSRs (RV32 only)
-
-        // 0x313 MRW 32 midelegh Upper 32 bits of of mideleg (only with S-mode)
-        // 0x314 MRW 32 mieh Upper 32 bits of mie
-        // 0x318 MRW 32 mvienh Upper 32 bits of mvien (only with S-mode)
-        // 0x319 MRW 32 mviph Upper 32 bits of mvip (only with S-mode)
-        // 0x354 MRW 32 miph Upper 32 bits of mip
-
-        //
-        // ZICSR extesnsion
-        //
-
-        // https://www.five-embeddev.com/riscv-priv-isa-manual/latest-adoc/priv-csrs.html
-        // https://xhypervisor.org/pdf/Xvisor_Embedded_Hypervisor_for_RISCV_v5.pdf
-
-        // https://riscv.org/technical/specifications/
-        // https://drive.google.com/file/d/17GeetSnT5wW3xNuAHI95-SI1gPGd5sJ_/view
-
-        // Privileged Hypervisor CSR addresses. from gdb/include/opcode/riscv-opc.h
-        // #define CSR_HSTATUS 0x600
-        // #define CSR_HEDELEG 0x602
-        // #define CSR_HIDELEG 0x603
-        // #define CSR_HIE 0x604
-        // #define CSR_HCOUNTEREN 0x606
-        // #define CSR_HGEIE 0x607
-        // #define CSR_HTVAL 0x643
-        // #define CSR_HIP 0x644
-        // #define CSR_HVIP 0x645
-        // #define CSR_HTINST 0x64a
-        // #define CSR_HGEIP 0xe12
-        // #define CSR_HENVCFG 0x60a
-        // #define CSR_HENVCFGH 0x61a
-        // #define CSR_HGATP 0x680
-        // #define CSR_HTIMEDELTA 0x605
-        // #define CSR_HTIMEDELTAH 0x615
-        case 0x600: return "CSR_HSTATUS"; // hypervisor status register, https://five-embeddev.com/riscv-priv-isa-manual/Priv-v1.12/priv-csrs.html
-        case 0x602: return "CSR_HEDELEG"; // hypervisor exception delegation register
-        case 0x603: return "CSR_HIDELEG"; // hypervisor interrupt delegation register
-        case 0x604: return "CSR_HIE"; // hypervisor interrupt-enable register
-        case 0x606: return "CSR_HCOUNTEREN"; // hypervisor counter enable
-        case 0x607: return "CSR_HGEIE"; // hypervisor guest external interrupt-enable register
-        case 0x643: return "CSR_HTVAL"; // hypervisor bad guest physical address
-        case 0x644: return "CSR_HIP"; // hypervisor interrupt pending
-        case 0x645: return "CSR_HVIP"; // hypervisor virtual interrupt pending
-        case 0x64a: return "CSR_HTINST"; // hypervisor trap instruction (transformed)
-        case 0xe12: return "CSR_HGEIP"; // hypervisor guest external interrupt pending
-        case 0x60a: return "CSR_HENVCFG"; // hypervisor evironment configuration register
-        case 0x61a: return "CSR_HENVCFGH"; // additional hypervisor evironment configuration register (RV32 only)
-        case 0x680: return "CSR_HGATP"; // hypervisor guest translation and protection
-        case 0x605: return "CSR_HTIMEDELTA"; // delta for VS/VU mode timer
-        case 0x615: return "CSR_HTIMEDELTAH"; // upper 32 bit of htimedelta, HSXLEN=32 only
-
-        
-
-        // https://riscv.org/wp-content/uploads/2019/03/riscv-debug-release.pdf
-        // 5.2.2 Trigger Data 1 (tdata1, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . . . 50
-        // 5.2.3 Trigger Data 2 (tdata2, at 0x7a2) . . . . . . . . . . . . . . . . . . . . . . . . 50
-        // 5.2.4 Trigger Data 3 (tdata3, at 0x7a3) . . . . . . . . . . . . . . . . . . . . . . . . 51
-        // 5.2.5 Trigger Info (tinfo, at 0x7a4) . . . . . . . . . . . . . . . . . . . . . . . . . . 51
-        // 5.2.6 Trigger Control (tcontrol, at 0x7a5) . . . . . . . . . . . . . . . . . . . . . . 51
-        // 5.2.7 Machine Context (mcontext, at 0x7a8) . . . . . . . . . . . . . . . . . . . . . 52
-        // 5.2.8 Supervisor Context (scontext, at 0x7aa) . . . . . . . . . . . . . . . . . . . . 52
-        // 5.2.9 Match Control (mcontrol, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . . 53
-        // 5.2.10 Instruction Count (icount, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . . 58
-        // 5.2.11 Interrupt Trigger (itrigger, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . 59
-        // 5.2.12 Exception Trigger (etrigger, at 0x7a1) . . . . . . . . . . . . . . . . . . . . . 60
-        // 5.2.13 Trigger Extra (RV32) (textra32, at 0x7a3) . . . . . . . . . . . . . . . . . . . 60
-        // 5.2.14 Trigger Extra (RV64) (textra64, at 0x7a3) . . . . . . . . . . . . . . . . . . . 61
-
-        case 0x07b0: return "Debug Control and Status (dcsr, at 0x7b0)";
-        case 0x07b1: return "Debug PC (dpc, at 0x7b1)";
-        case 0x07b2: return "Debug Scratch Register 0 (dscratch0, at 0x7b2)";
-        case 0x07b3: return "Debug Scratch Register 1 (dscratch1, at 0x7b3)";
-
-        // Found in riscv-gdb (gdb/include/opcode/riscv-opc.h)
-        // /* Unprivileged Vector CSR addresses.  */
-        // #define CSR_VSTART 0x008
-        // #define CSR_VXSAT 0x009
-        // #define CSR_VXRM 0x00a
-        // #define CSR_VCSR 0x00f
-        // #define CSR_VL 0xc20
-        // #define CSR_VTYPE 0xc21
-        // #define CSR_VLENB 0xc22
-        // 3106d = 0x0C22
-        case 0x0c22: return "SR_VLENB 0xc22";
-
-        // RISC-V Advanced Interrupt Architecture	June 2023	Smaia, Ssaia
-        // https://wiki.riscv.org/display/HOME/Ratified+Extensions
-        //
-        // Machine Level CSRs:
-        // 
-        case 0x0fb0: return "0x0fb0 - Machine Top Interrupt (mtopi)";
-
-        // 4104d == 0x1008
-        // Debug: 153 2980 riscv-013.c:703 riscv013_execute_abstract_command(): [riscv.cpu0] access register=0x321008 {regno=0x1008 write=arg0 transfer=enabled postexec=disabled aarpostincrement=disabled aarsize=64bit}
-        case 0x1008: return "s0/fp + gdb offset of 0x1000. I do not know why!";
-
-        default: return "UNKNOWN";
-
-    }
-
-}
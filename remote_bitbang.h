@@ -2,6 +2,7 @@
 #define REMOTE_BITBANG_H
 
 #include <chrono>
+#include <cstdio>
 #include <thread>
 #include <stdint.h>
 #include <sys/types.h>
@@ -14,6 +15,12 @@
 #include <sstream>
 
 #include "tap_state_machine.h"
+#include "bitbang_decoder.h"
+#include "scan_register.h"
+#include "scan_chain.h"
+#include "jtag_tap.h"
+#include "scan_trace.h"
+#include "debug_module.h"
 #include "riscv_assembler/cpu/cpu.h"
 
 // // instructions / register indexes
@@ -63,8 +70,8 @@ public:
 
     // The DMI uses between 7 and 32 address bits.
     // Each address points at a single 32-bit register that can be read or written.
-    const uint8_t ABITS_LENGTH = 7;
-    const uint16_t ABITS_MASK = 0b1111111;
+    const uint8_t ABITS_LENGTH = DebugModule::ABITS_LENGTH;
+    const uint16_t ABITS_MASK = DebugModule::ABITS_MASK;
     // const uint8_t ABITS_LENGTH = 16;
     // const uint16_t ABITS_MASK = 0b1111111111111111;
 
@@ -75,10 +82,95 @@ public:
     /// @param port the port where the server listens on for incoming JTAG bitbang connections (from openocd for example)
     remote_bitbang_t(uint16_t port, cpu_t* cpu);
 
+    /// @brief Constructor. Creates a session for a client that has already been accepted by a
+    /// remote_bitbang_server_t. Every session has its own TAP, DTM, DM and hart state.
+    /// @param client_fd the accepted client socket. The session takes ownership of the socket.
+    /// @param epoll_fd the epoll instance of the worker thread that serves this session
+    /// @param cpu the hart that this session debugs
+    remote_bitbang_t(int client_fd, int epoll_fd, cpu_t* cpu);
+
+    /// @brief Constructor. Creates the TAP, DTM, DM and hart state without any socket.
+    /// Used by test harnesses and benchmarks that talk to the DM through dmi_read() and dmi_write().
+    /// @param cpu the hart that is debugged
+    explicit remote_bitbang_t(cpu_t* cpu);
+
+    virtual ~remote_bitbang_t();
+
+    /// @brief Replaces the scan chain. By default the chain consists of the DTM only.
+    /// Has to be called before a client connects.
+    /// @param tap_configs the TAPs in the order of the openocd cfg (the first one is next to tdo).
+    /// Exactly one of them has to be the RISC-V DTM.
+    void set_tap_chain(const std::vector<jtag_tap_config_t>& tap_configs);
+
+    /// @brief Sets the register width of the hart the DM reports, 32 (the default) or 64.
+    /// Has to be called before a client connects.
+    void set_xlen(uint32_t xlen) { debug_module.set_xlen(xlen); }
+
+    /// @brief Records every completed IR and DR scan into the trace from now on.
+    /// @param scan_trace the trace, NULL stops recording. Not owned by the session.
+    void set_scan_trace(scan_trace_t* scan_trace) { this->scan_trace = scan_trace; }
+
+    scan_trace_t* get_scan_trace() { return scan_trace; }
+
+    /// @brief Writes the raw commands the client sends into path and the responses sent back into
+    /// path.tdo, so that remote_bitbang_replay can run the session again without openocd.
+    /// Aborts if the files cannot be created.
+    void start_recording(const char* path);
+
+    /// @brief amount of Update-IR the TAP went through
+    uint64_t get_ir_scan_count() { return ir_scan_count; }
+
+    /// @brief amount of Update-DR the TAP went through
+    uint64_t get_dr_scan_count() { return dr_scan_count; }
+
+    /// @brief amount of DMI reads and writes the DM has executed (nops are not counted)
+    uint64_t get_dmi_op_count() { return dmi_op_count; }
+
+    /// @brief Creates a non-blocking socket that listens on the given port on all interfaces.
+    /// @param port the port to listen on
+    /// @param backlog the length of the queue of pending connections
+    /// @param reuse_port if true, several sockets can listen on the same port (SO_REUSEPORT)
+    /// @return the listening socket. Aborts on failure.
+    static int open_listen_socket(uint16_t port, int backlog, bool reuse_port);
+
+    /// @brief Called by the worker of a remote_bitbang_server_t when the client socket of this
+    /// session is ready. Executes the commands the client has sent.
+    void handle_client_event();
+
+    /// @brief Reads a DM register directly, the same way an UPDATE_DR of the dmi register does,
+    /// but without going through JTAG and the socket.
+    /// @param address the DM register address (see DebugModule::register_as_string())
+    /// @param data receives the value of the register
+    /// @return the op field of the DMI response. 0 is success, 2 failed, 3 busy.
+    uint8_t dmi_read(uint32_t address, uint32_t& data);
+
+    /// @brief Writes a DM register directly, the same way an UPDATE_DR of the dmi register does,
+    /// but without going through JTAG and the socket.
+    /// @param address the DM register address (see DebugModule::register_as_string())
+    /// @param data the value to write
+    /// @return the op field of the DMI response. 0 is success, 2 failed, 3 busy.
+    uint8_t dmi_write(uint32_t address, uint32_t data);
+
+    /// @brief true as long as the client is connected
+    bool client_connected() { return client_fd > 0; }
+
+    int get_client_fd() { return client_fd; }
+
+    cpu_t* get_cpu() { return cpu; }
+
+    /// @brief Adds a hart to the DM, see DebugModule::add_hart(). Has to be called before a client connects.
+    void add_hart(cpu_t* hart) { debug_module.add_hart(hart); }
+
+    uint32_t get_hart_count() const { return debug_module.get_hart_count(); }
+
+    /// @brief The hart with the given index, hart 0 is get_cpu().
+    cpu_t* get_hart(uint32_t index) { return debug_module.get_hart(index); }
+
     /// @brief Called by the driver (main()) in an endless loop as long as the server has not received
     /// a quit command. Acts as the interface between the verilator implementation and the JTAG server.
     ///
-    /// First waits for a openocd JTAG bitbang client connection.
+    /// Blocks in epoll_wait() until a openocd JTAG bitbang client connects, sends commands or disconnects
+    /// (or until the poll timeout expires, see set_poll_timeout()).
     /// Once a client has connected, calls execute_command() which parses the incoming command and 
     /// executes specific handlers.
     ///
@@ -93,14 +185,112 @@ public:
               unsigned char *jtag_trstn,
               unsigned char jtag_tdo);
 
-    unsigned char done() { return quit; }
+    /// @brief true once the client has sent the quit command and all responses in front of it have been sent
+    unsigned char done() { return quit && (client_fd <= 0); }
+
+    /// @brief Sets how long tick() waits for socket events before it returns without having done anything.
+    /// @param timeout_ms timeout in milliseconds. -1 (the default) waits forever, 0 only polls.
+    void set_poll_timeout(int timeout_ms) { poll_timeout_ms = timeout_ms; }
 
     int exit_code() { return err; }
 
+    /// @brief Amount of rising clock edges that kept the TAP inside the given state, e.g. the
+    /// Run-Test/Idle cycles openocd asks for after each DMI access.
+    uint64_t get_self_loop_cycles(tsm_state state) { return self_loop_cycles[state]; }
+
     /// @brief Callback from the state machine. Called as the state machine enters a new state.
+    /// final, so that TSMStateMachine<remote_bitbang_t> can bind and inline the call at compile time.
     /// @param new_state the new state
     /// @param rising_edge_clk 
-    virtual void state_entered(tsm_state new_state, uint8_t rising_edge_clk) override;
+    virtual void state_entered(tsm_state new_state, uint8_t rising_edge_clk) override final;
+
+protected:
+
+    //
+    // transport interface. A transport (remote bitbang, jtag_vpi) decodes its protocol
+    // inside execute_command() and drives the TAP through the methods below.
+    //
+
+    /// @brief Execute any commands the client has for us. Reads everything the socket has into recv_buf
+    /// with a single syscall and decodes the whole batch before going back to the kernel.
+    virtual void execute_command();
+
+    /// @brief Flushes responses that are still pending from the previous batch.
+    /// @return false if the client has not accepted all of them yet and no new commands must be decoded.
+    bool begin_batch();
+
+    /// @brief Reads as much data as the socket has (and as fits) into recv_buf behind recv_end.
+    /// @return true if new data has arrived, false if there is nothing to read or the client has gone.
+    bool receive();
+
+    /// @brief Sends the responses of the batch and closes the connection if the client asked to quit.
+    /// With backpressure the connection is closed by begin_batch() once the responses have been sent.
+    void end_batch();
+
+    /// @brief Write the collected responses into the socket using non-blocking writes.
+    /// @return true if everything has been sent, false if the socket is full and data remains queued.
+    bool flush_send_buffer();
+
+    /// @brief Clocks a sequence of TMS values into the TAP (TDI is held low).
+    /// @param tms_bits the TMS values, bit 0 of byte 0 is clocked in first
+    /// @param nb_bits the amount of TMS values
+    void clock_tms_sequence(const uint8_t* tms_bits, uint32_t nb_bits);
+
+    /// @brief Clocks a whole scan through the current shift state (Shift-DR or Shift-IR).
+    /// @param tdi_bits the bits to shift in, bit 0 of byte 0 is shifted in first
+    /// @param tdo_bits receives the bits shifted out, same layout as tdi_bits
+    /// @param nb_bits length of the scan
+    /// @param exit_shift if true, TMS is raised on the last bit so that the TAP leaves the shift state
+    void clock_scan(const uint8_t* tdi_bits, uint8_t* tdo_bits, uint32_t nb_bits, bool exit_shift);
+
+    /// @brief TAP reset (trst) and system reset (srst). Signals trst and srst are active low.
+    /// @param trst TAP reset. performs TAP reset. Makes the state machine go back to TEST_LOGIC_RESET and writes IDCODE into DR
+    /// @param srst System rest. ??? no documentation found about what system reset does
+    void reset(char trst, char srst);
+
+    /// @brief Switches the client socket between waiting for input and waiting for the
+    /// socket to accept queued responses again (backpressure).
+    void watch_client_writable(bool enable);
+
+    /// @brief Sets the epoll events the client socket is watched for.
+    void watch_client(uint32_t events);
+
+    /// @brief Blocks until the listening socket or the client socket is ready and handles the event.
+    void wait_for_events();
+
+    /// @brief Handles an event of a further event source that a transport has registered with
+    /// epoll_fd (see remote_bitbang_pipeline_t). Called with and without a client connected.
+    /// @param fd the file descriptor that is ready
+    virtual void handle_event(int fd) {}
+
+    /// @brief Decodes and executes a batch of bitbang commands. Stops after a quit command.
+    /// @param commands the command characters sent by the client
+    /// @param count the amount of commands
+    /// @param responses receives one character per read command. Has to hold up to count characters.
+    /// @return the amount of responses
+    size_t process_commands(const char* commands, size_t count, char* responses);
+
+    /// @brief Decode and execute a single bitbang command character. This is the edge-level path
+    /// without the decoder and the fast paths of process_commands().
+    /// @param command the command character sent by the client
+    /// @param response receives the answer to a read command
+    /// @return true if the command produced a response
+    bool execute_single_command(char command, char& response);
+
+    unsigned char quit;
+
+    // socket server variables
+    int socket_fd;
+    int client_fd;
+    int epoll_fd{-1};
+    static const ssize_t buf_size = 64 * 1024;
+    char recv_buf[buf_size];
+    ssize_t recv_start, recv_end;
+
+    // responses ('R' commands) are collected here and written out once per decoded batch.
+    // A batch never holds more than buf_size commands, so it never produces more than buf_size responses.
+    char send_buf[buf_size];
+    ssize_t send_start, send_end;
 
 private:
 
@@ -121,31 +311,26 @@ private:
 
     int err;
 
-    unsigned char quit;
-
-    // socket server variables
-    int socket_fd;
-    int client_fd;
-    static const ssize_t buf_size = 64 * 1024;
-    char recv_buf[buf_size];
-    ssize_t recv_start, recv_end;
-
-    TSMStateMachine tsm_state_machine;
+    int poll_timeout_ms{-1};
+    uint32_t client_events{0};
+    // the state machine calls state_entered() directly, without going through the vtable
+    TSMStateMachine<remote_bitbang_t> tsm_state_machine;
 
     // this is IR
     uint8_t instruction_container_register{static_cast<uint8_t>(RiscV_DTM_Registers::JTAG_IDCODE)}; // after reset, store IDCODE
 
-    uint8_t instruction_shift_register{0};
+    // size of the ircode container register is 5 bits
+    ScanRegister instruction_scan_register{5};
 
     // this is the IDCODE container register which is indexed writing IDCODE into IR
     // uint32_t id_code_container_register = 0x05B4603F; // https://onlinedocs.microchip.com/oxy/GUID-C0DEC68F-9589-43E1-B26B-4C3E38933283-en-US-1/GUID-A95CFBC2-41D5-4755-AB8E-B4866693D026.html
     // uint32_t id_code_container_register = 0x20000c05; // https://community.platformio.org/t/openocd-flash-command-for-risc-v/26038/3
     uint32_t id_code_container_register = 0x20000913;
-    uint32_t id_code_shift_register{0}; // this is the IDCODE shift register
+    ScanRegister id_code_scan_register{32};
 
     // 6.1.4. DTM Control and Status (dtmcs, at 0x10)
     uint32_t dtmcs_container_register{0};
-    uint32_t dtmcs_shift_register{0};
+    ScanRegister dtmcs_scan_register{32};
 
     // 6.1.5. Debug Module Interface Access (dmi, at 0x11)
     //
@@ -153,26 +338,95 @@ private:
     // of registers inside the DM, the DM register can be read and written via
     // the DTM
     uint64_t dmi_container_register{0};
-    uint64_t dmi_shift_register{0};
+    ScanRegister dmi_scan_register{static_cast<uint32_t>(ABITS_LENGTH + 34)};
+
+    // the data register of the DTM that IR selects, NULL for BYPASS (see select_data_register())
+    ScanRegister* dtm_data_register{&id_code_scan_register};
+
+    // the TAPs of the scan chain, next to tdo first. NULL at the position of the DTM.
+    std::vector<jtag_tap_t*> taps;
+
+    // the IRs of all TAPs
+    ScanChain instruction_chain;
+
+    // the selected data registers of all TAPs (see build_data_chain())
+    ScanChain data_chain;
+
+    // the data register every TAP had selected when data_chain was built, NULL for BYPASS
+    std::vector<ScanRegister*> selected_data_registers;
+
+    // Every run of neighboring TAPs in BYPASS is a single scan register as wide as the run. A scan
+    // costs the same for any amount of bypassed TAPs. Never holds more entries than there are TAPs,
+    // so the pointers inside data_chain stay valid.
+    std::vector<ScanRegister> bypass_scan_registers;
+
+    // see set_scan_trace()
+    scan_trace_t* scan_trace{NULL};
 
-    //uint32_t status_container_register{0};
-    //uint32_t status_shift_register{0};
+    // see start_recording()
+    FILE* recorded_commands{NULL};
+    FILE* recorded_responses{NULL};
 
-    uint32_t abstractcs_container_register{0};
-    uint32_t abstractcs_shift_register{0};
+    uint64_t ir_scan_count{0};
+    uint64_t dr_scan_count{0};
+    uint64_t dmi_op_count{0};
 
-    uint8_t shift_amount{0};
+    // the bits of a whole DR scan, see apply_dmi_scan()
+    std::vector<uint8_t> scan_tdi_bits;
+    std::vector<uint8_t> scan_tdo_bits;
+
+    // The first falling edge inside Shift-DR does not shift (dtmcontrol_scan_via_bscan() inside openocd source code:
+    // "Note the starting offset is bit 1, not bit 0. In BSCAN tunnel, there is a one-bit TCK skew between output and input")
+    bool skip_dr_shift{false};
+
+    // dmi has been captured and process_commands() has not tried apply_dmi_scan() on the scan yet
+    bool dmi_scan_pending{false};
+
+    // states whose self loops are skipped as a whole by skip_stable_state()
+    static constexpr uint32_t stable_states = tsm_state_bit(TEST_LOGIC_RESET) | tsm_state_bit(RUN_TEST_IDLE) |
+        tsm_state_bit(PAUSE_DR) | tsm_state_bit(PAUSE_IR);
+
+    // see get_self_loop_cycles()
+    uint64_t self_loop_cycles[16]{0};
 
     /// @brief Check for a client connecting, and accept if there is one.
     void accept();
 
-    /// @brief Execute any commands the client has for us. But we only execute 1 because we need time for the simulation to run.
-    void execute_command();
+    /// @brief Sets up the values of the TAP/DTM registers and the pins.
+    void init_registers();
+
+    /// @brief Points dtm_data_register at the data register that IR selects.
+    void select_data_register();
+
+    /// @brief Connects the data registers the TAPs have selected to data_chain, if any of them
+    /// has changed its selection.
+    void build_data_chain();
+
+    /// @brief Executes the DMI request that is stored inside dmi_container_register against the DM
+    /// and places the response into dmi_container_register.
+    void execute_dmi_request();
+
+    /// @brief Makes the socket the client connection of this server and starts watching it.
+    void attach_client(int new_client_fd);
+
+    /// @brief Closes the client connection and goes back to waiting for the next client.
+    void disconnect_client();
+
+    /// @brief Applies the run of pin commands starting at first in O(1) if they all keep the TAP in
+    /// the stable state (Test-Logic-Reset, Run-Test/Idle, Pause-DR, Pause-IR) it currently is in.
+    /// @return the amount of commands applied, 0 if the TAP is not in a stable state or the command at
+    /// first leaves it
+    size_t skip_stable_state(const bitbang_block_t& block, size_t first);
+
+    /// @brief Applies the DR scan of the dmi register that starts at commands in one go, if the
+    /// commands are exactly the scan openocd sends: one falling edge, read and rising edge per bit
+    /// of the chain, leaving Shift-DR on the last bit.
+    /// @param commands the commands behind the skewed first falling edge of Shift-DR
+    /// @param count the amount of commands available
+    /// @param responses receives one response per bit of the data chain
+    /// @return the amount of commands applied, 0 if the commands have to take the edge-level path
+    size_t apply_dmi_scan(const char* commands, size_t count, char* responses);
 
-    /// @brief TAP reset (trst) and system reset (srst). Signals trst and srst are active low.
-    /// @param trst TAP reset. performs TAP reset. Makes the state machine go back to TEST_LOGIC_RESET and writes IDCODE into DR
-    /// @param srst System rest. ??? no documentation found about what system reset does
-    void reset(char trst, char srst);
 
     /// @brief
     /// @param _tck
@@ -201,142 +455,8 @@ private:
     /// @return a human readable name for the operation.
     std::string operation_as_string(uint64_t dmi_op);
 
-    std::string dm_register_as_string(uint32_t address);
-
-    //
-    // these variables all belong to the register 0x10 == DebugModule Control Register (DebugSpec, Page 26 and Page 30)
-    //
-
-    uint32_t haltreq = 0x00; // writing 0 clears the halt request for all currently selected harts. This may cancal outstanding halt requests for those harts.
-    uint32_t resumereq = 0x00;
-    uint32_t hartreset = 0x00;
-    uint32_t ackhavereset = 0x00;
-    uint32_t ackunavail = 0x00;
-    uint32_t hasel = 0x00;
-    uint32_t hartsello = 0x00; // ??? which (hardware thread) is selected
-    uint32_t hartselhi = 0x00;
-    uint32_t setkeepalive = 0x00;
-    uint32_t clrkeepalive = 0x00;
-    uint32_t setresethaltreq = 0x00;
-    uint32_t clrresethaltreq = 0x00;
-    uint32_t ndmreset = 0x00;
-    uint32_t dmactive = 0x00; // 0x00 module needs reset, 0x01 module functions normally.
-
-    //
-    // these variables all belong to the register 3.14.6. Abstract Control and Status (abstractcs, at 0x16)
-    //
-
-    // Writing this register while an abstract command is executing causes cmderr to become 1 (busy) once
-    // the command completes (busy becomes 0).
-
-    // progbufsize
-    uint32_t progbufsize = 0x00;
-
-    // 0 (ready): There is no abstract command currently being executed.
-    // 1 (busy): An abstract command is currently being executed
-    uint32_t busy = 0x00;
-
-    // This optional bit controls whether program buffer and
-    // abstract memory accesses are performed with the exact
-    // and full set of permission checks that apply based on the
-    // current architectural state of the hart performing the
-    // access, or with a relaxed set of permission checks (e.g. PMP
-    // restrictions are ignored). The details of the latter are
-    // implementation-specific.
-    // 0 (full checks): Full permission checks apply.
-    // 1 (relaxed checks): Relaxed permission checks apply
-    uint32_t relaxedpriv = 0x00;
-
-    // Gets set if an abstract command fails. The bits in this field
-    // remain set until they are cleared by writing 1 to them. No
-    // abstract command is started until the value is reset to 0.
-    // This field only contains a valid value if busy is 0.
-    // 0 (none): No error.
-    // 1 (busy): An abstract command was executing while
-    // command, abstractcs, or abstractauto was written, or when
-    // one of the data or progbuf registers was read or written.
-    // This status is only written if cmderr contains 0.
-    // 2 (not supported): The command in command is not
-    // supported. It may be supported with different options set,
-    // but it will not be supported at a later time when the hart or
-    // system state are different.
-    // 3 (exception): An exception occurred while executing the
-    // command (e.g. while executing the Program Buffer).
-    // 4 (halt/resume): The abstract command couldn’t execute
-    // because the hart wasn’t in the required state
-    // (running/halted), or unavailable.
-    // 5 (bus): The abstract command failed due to a bus error
-    // (e.g. alignment, access size, or timeout).
-    // 6 (reserved): Reserved for future use.
-    // 7 (other): The command failed for another reason.
-    uint32_t cmderr = 0x00;
-
-    // Number of data registers that are implemented as part of
-    // the abstract command interface. Valid sizes are 1 — 12.
-    uint32_t datacount = 0x00;
-
-    std::string riscv_register_as_string(uint32_t register_index);
-
-    // uint64_t abstract_data_0 = 0x00;
-    // uint64_t abstract_data_1 = 0x00;
-    // uint64_t abstract_data_2 = 0x00;
-    // uint64_t abstract_data_3 = 0x00;
-    // uint64_t abstract_data_4 = 0x00;
-    // uint64_t abstract_data_5 = 0x00;
-    // uint64_t abstract_data_6 = 0x00;
-    // uint64_t abstract_data_7 = 0x00;
-    // uint64_t abstract_data_8 = 0x00;
-    // uint64_t abstract_data_9 = 0x00;
-    // uint64_t abstract_data_10 = 0x00;
-    // uint64_t abstract_data_11 = 0x00;
-
-    uint64_t abstract_data[12]{0};
-
-    uint64_t arg0 = 0x00;
-    uint64_t arg1 = 0x00;
-    uint64_t arg2 = 0x00;
-
-    // debug program counter (this application uses it also for the programm counter of the RISCV chip)
-    //uint64_t dpc = 0x00;
-
-    // initialize to 0x40000000 simply because I found this post: https://stackoverflow.com/questions/69792036/how-do-i-set-up-data-memory-address-when-using-riscv32-64-unknown-elf-gcc
-    // It explains how to generate a ihex file with gcc without linker script that has it's code section at 0x40000000.
-    // The riscv chip will start execution there
-    uint64_t dpc = 0x40000000;
-
-    //  case 0, 0x00: return "zero";
-    //  case 1, 0x01: return "ra";
-    //  case 2, 0x02: return "sp";
-    //  case 3, 0x03: return "gp";
-    //  case 4, 0x04: return "tp";
-    //  case 5, 0x05: return "t0";
-    //  case 6, 0x06: return "t1";
-    //  case 7, 0x07: return "t2";
-    //  case 8, 0x08: return "s0/fp";
-    //  case 9, 0x09: return "s1";
-    // case 10, 0x0A: return "a0";
-    // case 11, 0x0B: return "a1";
-    // case 12, 0x0C: return "a2";
-    // case 13, 0x0D: return "a3";
-    // case 14, 0x0E: return "a4";
-    // case 15, 0x0F: return "a5";
-    // case 16, 0x10: return "a6";
-    // case 17, 0x11: return "a7";
-    // case 18, 0x12: return "s2";
-    // case 19, 0x13: return "s3";
-    // case 20, 0x14: return "s4";
-    // case 21, 0x15: return "s5";
-    // case 22, 0x16: return "s6";
-    // case 23, 0x17: return "s7";
-    // case 24, 0x18: return "s8";
-    // case 25, 0x19: return "s9";
-    // case 26, 0x1A: return "s10";
-    // case 27, 0x1B: return "s11";
-    // case 28, 0x1C: return "t3";
-    // case 29, 0x1D: return "t4";
-    // case 30, 0x1E: return "t5";
-    // case 31, 0x1F: return "t6";
-    //uint32_t register_file[32]{0};
+    // the DM behind the dmi register
+    DebugModule debug_module;
 
     cpu_t* cpu;
 
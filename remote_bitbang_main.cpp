@@ -1,16 +1,174 @@
 #include <iostream>
 #include <filesystem>
 #include <fstream> 
+#include <atomic>
+#include <cstring>
+#include <vector>
 
 #include "remote_bitbang.h"
+#include "jtag_vpi.h"
+#include "remote_bitbang_server.h"
+#include "remote_bitbang_pipeline.h"
+#include "jtag_tap.h"
+#include "scan_trace.h"
 #include "tap_state_machine.h"
 #include "riscv_assembler/ihex_loader/ihex_loader.h"
 #include "riscv_assembler/cpu/cpu.h"
 
-int main() {
+/// @brief Loads the ihex file into a memory image of its own and creates a hart that starts executing it.
+/// Used by the multi-session server, every session debugs its own hart.
+/// @return the hart or NULL if the ihex file cannot be loaded.
+static cpu_t* create_target_cpu(const std::string& ihex_file) {
+
+    IHexLoader ihex_loader;
+    if (ihex_loader.load_ihex_file(ihex_file)) {
+        return NULL;
+    }
+
+    cpu_t* cpu = new cpu_t;
+    cpu_init(cpu);
+    cpu->pc = ihex_loader.start_address;
+
+    // the loader allocates the segments, the copy of the map keeps them alive after the loader is gone
+    cpu->segments = new std::map<uint32_t, uint32_t*>(ihex_loader.segments);
+
+    return cpu;
+}
+
+/// @brief Adds harts to the session until it has hart_count of them. They share the memory image
+/// of the session's first hart and start executing at the same address.
+static void add_target_harts(remote_bitbang_t* session, uint32_t hart_count) {
+
+    cpu_t* first = session->get_cpu();
+    for (uint32_t i = 1; i < hart_count; i++) {
+        cpu_t* cpu = new cpu_t;
+        cpu_init(cpu);
+        cpu->pc = first->pc;
+        cpu->segments = first->segments;
+        session->add_hart(cpu);
+    }
+}
+
+/// @brief Frees the harts added by add_target_harts(), the first hart stays.
+static void release_target_harts(remote_bitbang_t* session) {
+
+    for (uint32_t i = 1; i < session->get_hart_count(); i++) {
+        delete session->get_hart(i);
+    }
+}
+
+/// @brief Frees a hart created by create_target_cpu() including its memory image.
+static void release_target_cpu(cpu_t* cpu) {
+
+    for (std::map<uint32_t, uint32_t*>::iterator it = cpu->segments->begin(); it != cpu->segments->end(); it++) {
+        delete[] it->second;
+    }
+    delete cpu->segments;
+    delete cpu;
+}
+
+static void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [--vpi] [--port <port>] [--server [--workers <count>] | --pipelined] [--tap <tap>]... [--trace <file> [--trace-records <count>]] [--record <file>] [--xlen <32|64>] [--harts <count>]" << std::endl;
+    std::cout << "  --vpi              speak openocd's jtag_vpi protocol instead of remote_bitbang" << std::endl;
+    std::cout << "  --port <port>      port to listen on for openocd (default 3335, 5555 for --vpi)" << std::endl;
+    std::cout << "  --server           serve many openocd clients at once, each one gets its own hart" << std::endl;
+    std::cout << "  --workers <count>  amount of worker threads for --server (default: one per core)" << std::endl;
+    std::cout << "  --pipelined        socket I/O and emulation run on two threads (remote_bitbang only)" << std::endl;
+    std::cout << "  --tap <tap>        adds a TAP to the scan chain, next to tdo first (default: a single dtm)" << std::endl;
+    std::cout << "                     <tap> is dtm[,5[,<idcode>]] or bypass[,<irlen>[,<idcode>]]" << std::endl;
+    std::cout << "  --trace <file>     records every IR and DR scan into the file (<file>.<n> per --server session)" << std::endl;
+    std::cout << "  --trace-records <count>  amount of scans the trace keeps (default 65536)" << std::endl;
+    std::cout << "  --record <file>    records the commands of the client into the file and the responses into <file>.tdo" << std::endl;
+    std::cout << "                     for remote_bitbang_replay (<file>.<n> per --server session, not with --vpi)" << std::endl;
+    std::cout << "  --xlen <32|64>     register width the hart reports to openocd (default 32)" << std::endl;
+    std::cout << "  --harts <count>    amount of harts behind the DM, they share the memory image (default 1)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
 
     std::cout << "Openocd JTAG bitbang sample target started ..." << std::endl;
 
+    uint16_t port = 0;
+    bool jtag_vpi = false;
+    bool multi_session = false;
+    bool pipelined = false;
+    uint32_t worker_count = 0;
+    std::vector<jtag_tap_config_t> tap_configs;
+    const char* trace_file = NULL;
+    uint64_t trace_records = 65536;
+    const char* record_file = NULL;
+    uint32_t xlen = 32;
+    uint32_t hart_count = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--port") == 0) && (i + 1 < argc)) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--vpi") == 0) {
+            jtag_vpi = true;
+        } else if (strcmp(argv[i], "--server") == 0) {
+            multi_session = true;
+        } else if ((strcmp(argv[i], "--workers") == 0) && (i + 1 < argc)) {
+            worker_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipelined") == 0) {
+            pipelined = true;
+        } else if ((strcmp(argv[i], "--tap") == 0) && (i + 1 < argc)) {
+            jtag_tap_config_t tap_config;
+            if (!parse_jtag_tap_config(argv[++i], tap_config)) {
+                std::cout << "Invalid TAP: " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return -1;
+            }
+            tap_configs.push_back(tap_config);
+        } else if ((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc)) {
+            trace_file = argv[++i];
+        } else if ((strcmp(argv[i], "--trace-records") == 0) && (i + 1 < argc)) {
+            trace_records = strtoull(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "--record") == 0) && (i + 1 < argc)) {
+            record_file = argv[++i];
+        } else if ((strcmp(argv[i], "--xlen") == 0) && (i + 1 < argc)) {
+            xlen = atoi(argv[++i]);
+        } else if ((strcmp(argv[i], "--harts") == 0) && (i + 1 < argc)) {
+            hart_count = strtoul(argv[++i], NULL, 0);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (((xlen != 32) && (xlen != 64)) || (hart_count == 0) || (hart_count > DebugModule::MAX_HART_COUNT)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (pipelined && (multi_session || jtag_vpi)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    // the replay decodes remote_bitbang commands only
+    if ((record_file != NULL) && jtag_vpi) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (!tap_configs.empty()) {
+        size_t dtm_count = 0;
+        for (size_t i = 0; i < tap_configs.size(); i++) {
+            if (tap_configs[i].role == JtagTapRole::RISCV_DTM) {
+                dtm_count++;
+            }
+        }
+        if (dtm_count != 1) {
+            std::cout << "The scan chain needs exactly one dtm TAP" << std::endl;
+            return -1;
+        }
+    }
+
+    // default ports of openocd's remote_bitbang and jtag_vpi adapter drivers
+    if (port == 0) {
+        port = jtag_vpi ? 5555 : 3335;
+    }
+
     //
     // load ihex file
     //
@@ -24,6 +182,61 @@ int main() {
     //std::string ihex_file = "test/resources/add_example.hex";
     std::string ihex_file = "loop_example/example.hex";
 
+    if (multi_session) {
+
+        // numbers the trace and recording files of the sessions
+        std::atomic<uint32_t> session_count{0};
+
+        remote_bitbang_server_t server(port, worker_count,
+            [&ihex_file, &tap_configs, &session_count, trace_file, trace_records, record_file, jtag_vpi, xlen, hart_count](int client_fd, int epoll_fd) -> remote_bitbang_t* {
+                // the ihex file may have become unreadable since the check at startup
+                cpu_t* cpu = create_target_cpu(ihex_file);
+                if (cpu == NULL) {
+                    return NULL;
+                }
+                remote_bitbang_t* session;
+                if (jtag_vpi) {
+                    session = new jtag_vpi_t(client_fd, epoll_fd, cpu);
+                } else {
+                    session = new remote_bitbang_t(client_fd, epoll_fd, cpu);
+                }
+                if (!tap_configs.empty()) {
+                    session->set_tap_chain(tap_configs);
+                }
+                session->set_xlen(xlen);
+                add_target_harts(session, hart_count);
+                uint32_t session_index = session_count.fetch_add(1);
+                if (trace_file != NULL) {
+                    std::string session_trace_file = std::string(trace_file) + "." + std::to_string(session_index);
+                    session->set_scan_trace(new scan_trace_t(session_trace_file.c_str(), trace_records));
+                }
+                if (record_file != NULL) {
+                    std::string session_record_file = std::string(record_file) + "." + std::to_string(session_index);
+                    session->start_recording(session_record_file.c_str());
+                }
+                return session;
+            },
+            [](remote_bitbang_t* session) {
+                cpu_t* cpu = session->get_cpu();
+                scan_trace_t* scan_trace = session->get_scan_trace();
+                release_target_harts(session);
+                delete session;
+                delete scan_trace;
+                release_target_cpu(cpu);
+            });
+
+        // check once that the ihex file can be loaded at all before serving clients
+        cpu_t* probe_cpu = create_target_cpu(ihex_file);
+        if (probe_cpu == NULL) {
+            return -1;
+        }
+        release_target_cpu(probe_cpu);
+
+        server.run();
+
+        return 0;
+    }
+
     IHexLoader ihex_loader;
     if (ihex_loader.load_ihex_file(ihex_file)) {
         return -1;
@@ -46,7 +259,47 @@ int main() {
 
     extern tsm_state tsm_current_state;
 
-    remote_bitbang_t remote_bitbang(3335, &cpu);
+    scan_trace_t* scan_trace = NULL;
+    if (trace_file != NULL) {
+        scan_trace = new scan_trace_t(trace_file, trace_records);
+    }
+
+    if (pipelined) {
+
+        // the TAP runs on the engine thread, there are no pins to hand out to a simulator
+        remote_bitbang_pipeline_t* remote_bitbang_pipeline = new remote_bitbang_pipeline_t(port, &cpu);
+        if (!tap_configs.empty()) {
+            remote_bitbang_pipeline->set_tap_chain(tap_configs);
+        }
+        remote_bitbang_pipeline->set_xlen(xlen);
+        add_target_harts(remote_bitbang_pipeline, hart_count);
+        remote_bitbang_pipeline->set_scan_trace(scan_trace);
+        if (record_file != NULL) {
+            remote_bitbang_pipeline->start_recording(record_file);
+        }
+        remote_bitbang_pipeline->run();
+        release_target_harts(remote_bitbang_pipeline);
+        delete remote_bitbang_pipeline;
+        delete scan_trace;
+
+        return 0;
+    }
+
+    remote_bitbang_t* remote_bitbang;
+    if (jtag_vpi) {
+        remote_bitbang = new jtag_vpi_t(port, &cpu);
+    } else {
+        remote_bitbang = new remote_bitbang_t(port, &cpu);
+    }
+    if (!tap_configs.empty()) {
+        remote_bitbang->set_tap_chain(tap_configs);
+    }
+    remote_bitbang->set_xlen(xlen);
+    add_target_harts(remote_bitbang, hart_count);
+    remote_bitbang->set_scan_trace(scan_trace);
+    if (record_file != NULL) {
+        remote_bitbang->start_recording(record_file);
+    }
 
     unsigned char jtag_tck = 0;
     unsigned char jtag_tms = 0;
@@ -54,9 +307,13 @@ int main() {
     unsigned char jtag_trstn = 0;
     unsigned char tag_tdo = 0;
 
-    while (!remote_bitbang.done()) {
-        remote_bitbang.tick(&jtag_tck, &jtag_tms, &jtag_tdi, &jtag_trstn, tag_tdo);
+    while (!remote_bitbang->done()) {
+        remote_bitbang->tick(&jtag_tck, &jtag_tms, &jtag_tdi, &jtag_trstn, tag_tdo);
     }
 
+    release_target_harts(remote_bitbang);
+    delete remote_bitbang;
+    delete scan_trace;
+
     return 0;
 }
@@ -0,0 +1,281 @@
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "remote_bitbang_pipeline.h"
+
+remote_bitbang_pipeline_t::remote_bitbang_pipeline_t(uint16_t port, cpu_t* cpu) : remote_bitbang_t(port, cpu)
+{
+    io_event_fd = eventfd(0, EFD_NONBLOCK);
+    engine_event_fd = eventfd(0, 0);
+    if ((io_event_fd == -1) || (engine_event_fd == -1))
+    {
+        fprintf(stderr, "remote_bitbang_pipeline failed to create eventfd: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+
+    // the engine wakes up the I/O thread whenever it has produced responses or made room in the command ring
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = io_event_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, io_event_fd, &event) == -1)
+    {
+        fprintf(stderr, "remote_bitbang_pipeline failed to watch the eventfd: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+
+    engine_thread = std::thread(&remote_bitbang_pipeline_t::engine, this);
+}
+
+remote_bitbang_pipeline_t::~remote_bitbang_pipeline_t()
+{
+    engine_stop.store(true);
+    signal(engine_event_fd);
+    engine_thread.join();
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, io_event_fd, NULL);
+    close(io_event_fd);
+    close(engine_event_fd);
+}
+
+void remote_bitbang_pipeline_t::run()
+{
+    while (!done())
+    {
+        wait_for_events();
+    }
+}
+
+void remote_bitbang_pipeline_t::handle_event(int fd)
+{
+    if (fd != io_event_fd)
+    {
+        return;
+    }
+
+    if (client_connected())
+    {
+        execute_command();
+        return;
+    }
+
+    // the engine has finished the last batch of a client that has gone already (see drain_engine())
+    wait_for_signal(io_event_fd);
+}
+
+void remote_bitbang_pipeline_t::execute_command()
+{
+    wait_for_signal(io_event_fd);
+
+    // if the engine is idle at this point, all of its responses are inside the response ring already
+    bool engine_finished = engine_quit.load() && (commands_done.load() == commands_pushed);
+
+    forward_responses();
+    if (!client_connected())
+    {
+        drain_engine();
+        return;
+    }
+
+    // quit once the responses to all commands in front of the quit command have been sent
+    if (engine_finished && (send_start == send_end))
+    {
+        quit = 1;
+        end_batch();
+        drain_engine();
+        return;
+    }
+
+    // only read new commands once the previous ones are all inside the command ring
+    if ((recv_start == recv_end) && !engine_quit.load())
+    {
+        recv_start = 0;
+        recv_end = 0;
+
+        if (!receive() && !client_connected())
+        {
+            drain_engine();
+            return;
+        }
+    }
+
+    if (recv_start < recv_end)
+    {
+        size_t pushed = command_ring.push(recv_buf + recv_start, recv_end - recv_start);
+        if (pushed > 0)
+        {
+            recv_start += pushed;
+            commands_pushed += pushed;
+            signal(engine_event_fd);
+        }
+    }
+
+    // While the command ring is full, the engine's eventfd says when to continue. Waiting for the
+    // socket to become readable at the same time would only spin.
+    uint32_t events = 0;
+    if ((recv_start == recv_end) && !engine_quit.load())
+    {
+        events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (send_start < send_end)
+    {
+        events |= EPOLLOUT;
+    }
+    watch_client(events);
+}
+
+void remote_bitbang_pipeline_t::forward_responses()
+{
+    while (true)
+    {
+        size_t room = buf_size - send_end;
+        size_t popped = response_ring.pop(send_buf + send_end, room);
+        if (popped > 0)
+        {
+            send_end += popped;
+
+            // the engine might wait for room inside the response ring
+            signal(engine_event_fd);
+        }
+
+        if (send_start == send_end)
+        {
+            return;
+        }
+
+        // socket full (or client gone), the rest is sent once the socket is writable again
+        if (!flush_send_buffer())
+        {
+            return;
+        }
+
+        // the response ring is empty. A full send buffer only stopped the pop, the ring may hold more.
+        if ((popped == 0) && (room > 0))
+        {
+            return;
+        }
+    }
+}
+
+void remote_bitbang_pipeline_t::drain_engine()
+{
+    char discard[4096];
+
+    // The engine signals io_event_fd after every batch (after commands_done has been updated) and
+    // whenever the response ring is full. The eventfd counts the signals, so none is lost.
+    while (commands_done.load() != commands_pushed)
+    {
+        while (response_ring.pop(discard, sizeof(discard)) > 0)
+        {
+        }
+
+        // the engine might wait for room inside the response ring
+        signal(engine_event_fd);
+        wait_for_signal_blocking(io_event_fd);
+    }
+
+    while (response_ring.pop(discard, sizeof(discard)) > 0)
+    {
+    }
+
+    // a signal that is still pending is cleared by handle_event()
+    wait_for_signal(io_event_fd);
+    engine_quit.store(false);
+}
+
+void remote_bitbang_pipeline_t::engine()
+{
+    char commands[4096];
+    char responses[4096];
+
+    while (!engine_stop.load())
+    {
+        size_t count = command_ring.pop(commands, sizeof(commands));
+        if (count == 0)
+        {
+            wait_for_signal(engine_event_fd);
+            continue;
+        }
+
+        // nothing after the quit command is executed
+        if (!engine_quit.load())
+        {
+            const char* quit_command = static_cast<const char*>(memchr(commands, 'Q', count));
+            size_t execute_count = (quit_command != NULL) ? (quit_command - commands) : count;
+
+            size_t response_count = process_commands(commands, execute_count, responses);
+
+            size_t pushed = 0;
+            while ((pushed < response_count) && !engine_stop.load())
+            {
+                pushed += response_ring.push(responses + pushed, response_count - pushed);
+                if (pushed < response_count)
+                {
+                    // response ring full, let the I/O thread empty it
+                    signal(io_event_fd);
+                    wait_for_signal(engine_event_fd);
+                }
+            }
+
+            if (quit_command != NULL)
+            {
+                engine_quit.store(true);
+            }
+        }
+
+        commands_done.fetch_add(count);
+        signal(io_event_fd);
+    }
+}
+
+void remote_bitbang_pipeline_t::signal(int event_fd)
+{
+    uint64_t value = 1;
+    if (write(event_fd, &value, sizeof(value)) == -1)
+    {
+        // EAGAIN means the counter is saturated, the other thread is signaled in any case
+        if (errno != EAGAIN)
+        {
+            fprintf(stderr, "remote_bitbang_pipeline failed to signal eventfd: %s (%d)\n", strerror(errno), errno);
+            abort();
+        }
+    }
+}
+
+void remote_bitbang_pipeline_t::wait_for_signal(int event_fd)
+{
+    uint64_t value;
+    if (read(event_fd, &value, sizeof(value)) == -1)
+    {
+        if ((errno != EAGAIN) && (errno != EINTR))
+        {
+            fprintf(stderr, "remote_bitbang_pipeline failed to read eventfd: %s (%d)\n", strerror(errno), errno);
+            abort();
+        }
+    }
+}
+
+void remote_bitbang_pipeline_t::wait_for_signal_blocking(int event_fd)
+{
+    struct pollfd readable;
+    readable.fd = event_fd;
+    readable.events = POLLIN;
+    readable.revents = 0;
+
+    while (poll(&readable, 1, -1) == -1)
+    {
+        if (errno != EINTR)
+        {
+            fprintf(stderr, "remote_bitbang_pipeline failed to poll eventfd: %s (%d)\n", strerror(errno), errno);
+            abort();
+        }
+    }
+
+    wait_for_signal(event_fd);
+}
@@ -0,0 +1,93 @@
+#ifndef REMOTE_BITBANG_PIPELINE_H
+#define REMOTE_BITBANG_PIPELINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "remote_bitbang.h"
+#include "spsc_ring.h"
+
+// Serves a single openocd remote_bitbang client with two threads.
+//
+// The I/O thread (the one calling run()) owns the sockets. It pushes the raw command bytes into
+// the command ring and writes the TDO bytes it finds in the response ring into the socket.
+// The engine thread pops the commands, runs them through the TAP, DTM, DM and hart and pushes
+// the responses back. The threads wake each other up through eventfds, so neither of them spins.
+// Network latency therefore overlaps with emulation work instead of adding up.
+class remote_bitbang_pipeline_t : public remote_bitbang_t
+{
+
+public:
+
+    /// @brief constructor. Starts the engine thread.
+    /// @param port the port for the server to listen on for new connections.
+    /// @param cpu the hart that is debugged.
+    remote_bitbang_pipeline_t(uint16_t port, cpu_t* cpu);
+
+    /// @brief Stops the engine thread.
+    virtual ~remote_bitbang_pipeline_t();
+
+    /// @brief Runs the I/O thread until the client sends the quit command.
+    void run();
+
+protected:
+
+    /// @brief I/O thread side. Forwards responses to the client and commands to the engine.
+    virtual void execute_command() override;
+
+    /// @brief The engine has signaled io_event_fd. Serves the client or, without a client, only
+    /// clears the eventfd.
+    virtual void handle_event(int fd) override;
+
+private:
+
+    static const size_t ring_size = 64 * 1024;
+
+    // I/O thread -> engine thread
+    spsc_ring_t<char, ring_size> command_ring;
+
+    // engine thread -> I/O thread
+    spsc_ring_t<char, ring_size> response_ring;
+
+    // the I/O thread waits for this one inside epoll_wait()
+    int io_event_fd{-1};
+
+    // the engine thread blocks on this one while it has nothing to do
+    int engine_event_fd{-1};
+
+    // written by the I/O thread only
+    uint64_t commands_pushed{0};
+
+    // written by the engine thread only. Equals commands_pushed when the engine is idle.
+    std::atomic<uint64_t> commands_done{0};
+
+    // the engine has executed a quit command
+    std::atomic<bool> engine_quit{false};
+
+    std::atomic<bool> engine_stop{false};
+
+    std::thread engine_thread;
+
+    /// @brief The engine thread.
+    void engine();
+
+    /// @brief Moves responses from the response ring into the socket.
+    void forward_responses();
+
+    /// @brief Waits until the engine has executed every command of the client that has just left
+    /// and drops the responses, so that the next client starts with empty rings.
+    void drain_engine();
+
+    /// @brief Wakes up the thread that waits on the eventfd.
+    static void signal(int event_fd);
+
+    /// @brief Blocks until the eventfd is signaled (or only clears it, if it is non-blocking).
+    static void wait_for_signal(int event_fd);
+
+    /// @brief Blocks until the eventfd is signaled and clears it, also if it is non-blocking.
+    static void wait_for_signal_blocking(int event_fd);
+
+};
+
+#endif
@@ -0,0 +1,369 @@
+#include <inttypes.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "remote_bitbang.h"
+#include "jtag_tap.h"
+#include "riscv_assembler/ihex_loader/ihex_loader.h"
+#include "riscv_assembler/cpu/cpu.h"
+
+// Feeds a session recorded with --record through the same decode, TAP, DTM and DM code as a
+// socket session, without a socket and as fast as possible.
+//
+// Reports commands/s, scans/s and DMI ops/s and compares the produced TDO responses with the
+// responses that have been recorded (<file>.tdo), so that every change of the engine can be
+// checked and measured without openocd in the loop.
+
+// a segment of the memory image covers 64 KiB (see IHexLoader)
+static const size_t segment_words = 0x10000 / sizeof(uint32_t);
+
+// how a recording is fed into the session
+enum class replay_mode_t : uint8_t
+{
+    // batches of buf_size through process_commands(), as a socket session does
+    BATCHES,
+
+    // one command at a time through execute_single_command(), the reference for the fast paths
+    EDGES,
+
+    // batches of a single command through process_commands()
+    SINGLE_COMMANDS,
+
+    // batches of 1 to 256 commands through process_commands(), the way a socket cuts the stream
+    RANDOM_BATCHES
+};
+
+// exposes the batch decoder of a socket-free session
+class remote_bitbang_replay_t : public remote_bitbang_t
+{
+
+public:
+
+    explicit remote_bitbang_replay_t(cpu_t* cpu) : remote_bitbang_t(cpu) {}
+
+    /// @brief Runs the commands through the session.
+    /// @param commands the recorded commands
+    /// @param mode how the commands are fed into the session
+    /// @param responses receives the responses, as many as there are read commands
+    void replay(const std::vector<char>& commands, replay_mode_t mode, std::vector<char>& responses)
+    {
+        responses.resize(commands.size());
+
+        size_t response_count = 0;
+        if (mode == replay_mode_t::EDGES)
+        {
+            for (size_t i = 0; (i < commands.size()) && !done(); i++)
+            {
+                if (execute_single_command(commands[i], responses[response_count]))
+                {
+                    response_count++;
+                }
+            }
+        }
+        else
+        {
+            // a fixed seed, so that a difference can be reproduced
+            std::mt19937 random(1);
+
+            size_t offset = 0;
+            while ((offset < commands.size()) && !done())
+            {
+                size_t batch = buf_size;
+                if (mode == replay_mode_t::SINGLE_COMMANDS)
+                {
+                    batch = 1;
+                }
+                else if (mode == replay_mode_t::RANDOM_BATCHES)
+                {
+                    batch = 1 + random() % 256;
+                }
+
+                size_t count = std::min<size_t>(batch, commands.size() - offset);
+                response_count += process_commands(commands.data() + offset, count, responses.data() + response_count);
+                offset += count;
+            }
+        }
+
+        responses.resize(response_count);
+    }
+
+};
+
+// the target a recording has been made with
+struct replay_target_t
+{
+    IHexLoader ihex_loader;
+    std::vector<jtag_tap_config_t> tap_configs;
+    uint32_t xlen{32};
+    uint32_t hart_count{1};
+};
+
+// the outcome of a single run of a recording
+struct replay_run_t
+{
+    std::vector<char> responses;
+    std::chrono::duration<double> elapsed{0};
+    uint64_t scans{0};
+    uint64_t dmi_ops{0};
+
+    // rising edges that kept the TAP in place, per state
+    uint64_t self_loop_cycles[16]{0};
+};
+
+/// @brief Runs a recording once, with a fresh TAP, DM and harts.
+static void run_recording(const replay_target_t& target, const std::vector<char>& commands, replay_mode_t mode, replay_run_t& run)
+{
+    // every run starts from the memory image of the ihex file, the previous run may have written to it
+    std::map<uint32_t, uint32_t*> segments;
+    for (std::map<uint32_t, uint32_t*>::const_iterator it = target.ihex_loader.segments.begin(); it != target.ihex_loader.segments.end(); it++)
+    {
+        segments[it->first] = new uint32_t[segment_words];
+        memcpy(segments[it->first], it->second, segment_words * sizeof(uint32_t));
+    }
+
+    // the harts share the memory image
+    std::vector<cpu_t> harts(target.hart_count);
+    for (uint32_t hart = 0; hart < target.hart_count; hart++)
+    {
+        cpu_init(&harts[hart]);
+        harts[hart].pc = target.ihex_loader.start_address;
+        harts[hart].segments = &segments;
+    }
+    cpu_t& cpu = harts[0];
+
+    remote_bitbang_replay_t session(&cpu);
+    if (!target.tap_configs.empty())
+    {
+        session.set_tap_chain(target.tap_configs);
+    }
+    session.set_xlen(target.xlen);
+    for (uint32_t hart = 1; hart < target.hart_count; hart++)
+    {
+        session.add_hart(&harts[hart]);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    session.replay(commands, mode, run.responses);
+    run.elapsed = std::chrono::steady_clock::now() - start;
+
+    run.scans = session.get_ir_scan_count() + session.get_dr_scan_count();
+    run.dmi_ops = session.get_dmi_op_count();
+    for (uint32_t state = 0; state < 16; state++)
+    {
+        run.self_loop_cycles[state] = session.get_self_loop_cycles(static_cast<tsm_state>(state));
+    }
+
+    for (std::map<uint32_t, uint32_t*>::iterator it = segments.begin(); it != segments.end(); it++)
+    {
+        delete[] it->second;
+    }
+}
+
+/// @brief Compares responses with reference responses.
+/// @param first_mismatch receives the index of the first response that differs
+/// @return the amount of responses that differ, missing and surplus responses count as differing
+static size_t compare_responses(const std::vector<char>& responses, const std::vector<char>& reference, size_t& first_mismatch)
+{
+    size_t compared = std::min(responses.size(), reference.size());
+    size_t mismatches = 0;
+    first_mismatch = compared;
+    for (size_t i = 0; i < compared; i++)
+    {
+        if (responses[i] != reference[i])
+        {
+            if (mismatches == 0)
+            {
+                first_mismatch = i;
+            }
+            mismatches++;
+        }
+    }
+
+    return mismatches + std::max(responses.size(), reference.size()) - compared;
+}
+
+static bool read_file(const char* path, std::vector<char>& content)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s <recording> [--repeat <count>] [--check] [--ihex <file>] [--tap <tap>]... [--xlen <32|64>] [--harts <count>]\n", program);
+    printf("  <recording>        commands recorded with --record, the responses are expected in <recording>.tdo\n");
+    printf("  --repeat <count>   runs the recording count times, each time with a fresh TAP, DM and hart (default 1)\n");
+    printf("  --check            also runs the recording through the edge-level path, in batches of one command and in\n");
+    printf("                     batches of random size and compares responses and clocks with the batched run\n");
+    printf("  --ihex <file>      the program of the hart (default loop_example/example.hex)\n");
+    printf("  --tap <tap>        the scan chain the recording has been made with, see a.out --help\n");
+    printf("  --xlen <32|64>     the register width the recording has been made with (default 32)\n");
+    printf("  --harts <count>    the amount of harts the recording has been made with (default 1)\n");
+}
+
+int main(int argc, char* argv[])
+{
+    const char* recording = NULL;
+    uint32_t repeat = 1;
+    bool check = false;
+    std::string ihex_file = "loop_example/example.hex";
+    replay_target_t target;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--repeat") == 0) && (i + 1 < argc))
+        {
+            repeat = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--check") == 0)
+        {
+            check = true;
+        }
+        else if ((strcmp(argv[i], "--ihex") == 0) && (i + 1 < argc))
+        {
+            ihex_file = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--tap") == 0) && (i + 1 < argc))
+        {
+            jtag_tap_config_t tap_config;
+            if (!parse_jtag_tap_config(argv[++i], tap_config))
+            {
+                print_usage(argv[0]);
+                return -1;
+            }
+            target.tap_configs.push_back(tap_config);
+        }
+        else if ((strcmp(argv[i], "--xlen") == 0) && (i + 1 < argc))
+        {
+            target.xlen = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--harts") == 0) && (i + 1 < argc))
+        {
+            target.hart_count = strtoul(argv[++i], NULL, 0);
+        }
+        else if ((argv[i][0] != '-') && (recording == NULL))
+        {
+            recording = argv[i];
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if ((recording == NULL) || (repeat == 0) || ((target.xlen != 32) && (target.xlen != 64)) ||
+        (target.hart_count == 0) || (target.hart_count > DebugModule::MAX_HART_COUNT))
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    std::vector<char> commands;
+    if (!read_file(recording, commands))
+    {
+        fprintf(stderr, "[Error] cannot read %s\n", recording);
+        return -1;
+    }
+
+    std::vector<char> reference;
+    std::string reference_path = std::string(recording) + ".tdo";
+    bool has_reference = read_file(reference_path.c_str(), reference);
+
+    if (target.ihex_loader.load_ihex_file(ihex_file))
+    {
+        return -1;
+    }
+
+    std::chrono::duration<double> elapsed(0);
+    uint64_t scans = 0;
+    uint64_t dmi_ops = 0;
+    replay_run_t run;
+
+    for (uint32_t i = 0; i < repeat; i++)
+    {
+        run_recording(target, commands, replay_mode_t::BATCHES, run);
+
+        elapsed += run.elapsed;
+        scans += run.scans;
+        dmi_ops += run.dmi_ops;
+    }
+
+    double seconds = elapsed.count();
+    printf("replayed %zu commands %u times in %.3f s\n", commands.size(), repeat, seconds);
+    printf("%12.1f M commands/s\n", (static_cast<double>(commands.size()) * repeat) / seconds / 1e6);
+    printf("%12.1f k scans/s\n", static_cast<double>(scans) / seconds / 1e3);
+    printf("%12.1f k DMI ops/s\n", static_cast<double>(dmi_ops) / seconds / 1e3);
+
+    // where the clocks of a run went that did not move the TAP, the idle and pause runs are
+    // what skip_stable_state() applies in O(1)
+    printf("clocks in place per run: %" PRIu64 " Test-Logic-Reset, %" PRIu64 " Run-Test/Idle, %" PRIu64 " Shift-DR/IR, %" PRIu64 " Pause-DR/IR\n",
+        run.self_loop_cycles[TEST_LOGIC_RESET], run.self_loop_cycles[RUN_TEST_IDLE],
+        run.self_loop_cycles[SHIFT_DR] + run.self_loop_cycles[SHIFT_IR],
+        run.self_loop_cycles[PAUSE_DR] + run.self_loop_cycles[PAUSE_IR]);
+
+    int result = 0;
+
+    if (check)
+    {
+        // the fast paths (decoder, skip_stable_state(), apply_dmi_scan()) have to produce the same
+        // responses and count the same clocks as the edge-level path, however the stream is cut into batches
+        static const struct { replay_mode_t mode; const char* name; } checks[] = {
+            { replay_mode_t::EDGES, "edge-level path" },
+            { replay_mode_t::SINGLE_COMMANDS, "batches of one command" },
+            { replay_mode_t::RANDOM_BATCHES, "batches of random size" }
+        };
+
+        for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++)
+        {
+            replay_run_t other;
+            run_recording(target, commands, checks[i].mode, other);
+
+            size_t first_mismatch;
+            size_t mismatches = compare_responses(other.responses, run.responses, first_mismatch);
+            bool same_clocks = (memcmp(run.self_loop_cycles, other.self_loop_cycles, sizeof(run.self_loop_cycles)) == 0);
+            if ((mismatches == 0) && same_clocks)
+            {
+                printf("%s: identical responses and clocks in place\n", checks[i].name);
+            }
+            else
+            {
+                printf("%s differs: %zu responses differ, first at response %zu, clocks in place %s\n",
+                    checks[i].name, mismatches, first_mismatch, same_clocks ? "identical" : "differ");
+                result = 1;
+            }
+        }
+    }
+
+    if (!has_reference)
+    {
+        printf("no reference responses (%s), TDO not compared\n", reference_path.c_str());
+        return result;
+    }
+
+    // compare the responses of the last run with the recorded ones
+    size_t first_mismatch;
+    size_t mismatches = compare_responses(run.responses, reference, first_mismatch);
+    if (mismatches == 0)
+    {
+        printf("TDO identical to the reference (%zu responses)\n", run.responses.size());
+        return result;
+    }
+
+    printf("TDO differs from the reference: %zu responses differ, first at response %zu, %zu responses produced, %zu recorded\n",
+        mismatches, first_mismatch, run.responses.size(), reference.size());
+    return 1;
+}
@@ -0,0 +1,143 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+
+#include "remote_bitbang_server.h"
+
+remote_bitbang_server_t::remote_bitbang_server_t(uint16_t port, uint32_t worker_count,
+    session_factory_t create_session, session_release_t release_session) : port(port),
+                                                    worker_count(worker_count),
+                                                    create_session(create_session),
+                                                    release_session(release_session)
+{
+    if (this->worker_count == 0)
+    {
+        this->worker_count = std::thread::hardware_concurrency();
+    }
+    if (this->worker_count == 0)
+    {
+        this->worker_count = 1;
+    }
+}
+
+void remote_bitbang_server_t::run()
+{
+    fprintf(stderr, "Multi-session server listening on port %d with %d workers\n", port, worker_count);
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        workers.push_back(std::thread(&remote_bitbang_server_t::worker, this, i));
+    }
+
+    for (std::thread& worker_thread : workers)
+    {
+        worker_thread.join();
+    }
+}
+
+void remote_bitbang_server_t::worker(uint32_t worker_index)
+{
+    // every worker has its own listening socket on the shared port, the kernel
+    // hands each new connection to exactly one of them
+    int listen_fd = remote_bitbang_t::open_listen_socket(port, SOMAXCONN, true);
+
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd == -1)
+    {
+        fprintf(stderr, "remote_bitbang_server worker %d failed to create epoll instance: %s (%d)\n", worker_index, strerror(errno), errno);
+        abort();
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) == -1)
+    {
+        fprintf(stderr, "remote_bitbang_server worker %d failed to watch the listening socket: %s (%d)\n", worker_index, strerror(errno), errno);
+        abort();
+    }
+
+    // client socket -> session
+    std::unordered_map<int, remote_bitbang_t*> sessions;
+
+    const int max_events = 64;
+    struct epoll_event events[max_events];
+
+    while (true)
+    {
+        int count = epoll_wait(epoll_fd, events, max_events, -1);
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "remote_bitbang_server worker %d epoll_wait failed: %s (%d)\n", worker_index, strerror(errno), errno);
+            abort();
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if (fd == listen_fd)
+            {
+                // accept everything that is pending
+                while (true)
+                {
+                    int client_fd = ::accept(listen_fd, NULL, NULL);
+                    if (client_fd == -1)
+                    {
+                        if ((errno == EINTR) || (errno == ECONNABORTED))
+                        {
+                            continue;
+                        }
+                        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                        {
+                            fprintf(stderr, "remote_bitbang_server worker %d failed to accept on socket: %s (%d)\n", worker_index, strerror(errno), errno);
+                        }
+                        break;
+                    }
+
+                    remote_bitbang_t* session = create_session(client_fd, epoll_fd);
+                    if (session == NULL)
+                    {
+                        fprintf(stderr, "worker %d could not create a session (fd %d), closing the client\n", worker_index, client_fd);
+                        ::close(client_fd);
+                        continue;
+                    }
+                    sessions[client_fd] = session;
+
+                    fprintf(stderr, "worker %d accepted session (fd %d). %zu sessions on this worker\n", worker_index, client_fd, sessions.size());
+                }
+
+                continue;
+            }
+
+            std::unordered_map<int, remote_bitbang_t*>::iterator it = sessions.find(fd);
+            if (it == sessions.end())
+            {
+                // stale event of a session that has been released in this very batch
+                continue;
+            }
+
+            remote_bitbang_t* session = it->second;
+            session->handle_client_event();
+
+            if (!session->client_connected())
+            {
+                sessions.erase(it);
+                release_session(session);
+
+                fprintf(stderr, "worker %d released session (fd %d). %zu sessions on this worker\n", worker_index, fd, sessions.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef REMOTE_BITBANG_SERVER_H
+#define REMOTE_BITBANG_SERVER_H
+
+#include <stdint.h>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "remote_bitbang.h"
+
+// Serves many openocd clients at the same time.
+//
+// Each accepted connection becomes a session (a remote_bitbang_t) with its own TAP, DTM, DM and hart.
+// Sessions are spread across a pool of worker threads. Every worker owns a listening socket that is
+// bound to the same port (SO_REUSEPORT), so the kernel distributes incoming connections among the
+// workers. A worker serves all of its sessions from a single epoll loop.
+class remote_bitbang_server_t
+{
+
+public:
+
+    /// @brief Creates the session for an accepted client.
+    /// The first parameter is the client socket, the second one is the epoll instance of the worker.
+    typedef std::function<remote_bitbang_t*(int, int)> session_factory_t;
+
+    /// @brief Releases a session (and everything it owns, e.g. the hart) after the client has left.
+    typedef std::function<void(remote_bitbang_t*)> session_release_t;
+
+    /// @brief Constructor.
+    /// @param port the port where all workers listen for incoming JTAG bitbang connections
+    /// @param worker_count amount of worker threads. 0 uses one worker per core.
+    /// @param create_session called by a worker whenever a client connects. Returns NULL if there is
+    /// no session for the client, the worker closes the client then.
+    /// @param release_session called by a worker whenever a client disconnects
+    remote_bitbang_server_t(uint16_t port, uint32_t worker_count,
+        session_factory_t create_session, session_release_t release_session);
+
+    /// @brief Starts the workers and serves clients forever.
+    void run();
+
+private:
+
+    uint16_t port;
+
+    uint32_t worker_count;
+
+    session_factory_t create_session;
+
+    session_release_t release_session;
+
+    std::vector<std::thread> workers;
+
+    /// @brief The event loop of a single worker thread.
+    /// @param worker_index index of the worker, used for log output only
+    void worker(uint32_t worker_index);
+
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "scan_chain.h"
+
+static inline uint64_t low_bits_mask(uint32_t count)
+{
+    return (count >= 64) ? ~0ULL : ((1ULL << count) - 1);
+}
+
+void ScanChain::clear()
+{
+    registers.clear();
+    width = 0;
+}
+
+void ScanChain::append(ScanRegister* scan_register)
+{
+    registers.push_back(scan_register);
+    width += scan_register->get_width();
+}
+
+uint64_t ScanChain::shift(uint64_t tdi_bits, uint32_t count)
+{
+    for (size_t i = registers.size(); i-- > 0;)
+    {
+        tdi_bits = registers[i]->shift(tdi_bits, count);
+    }
+    return tdi_bits;
+}
+
+void ScanChain::shift(const uint8_t* tdi_bits, uint8_t* tdo_bits, uint32_t first, uint32_t count)
+{
+    while (count > 0)
+    {
+        uint32_t chunk = (count < 64) ? count : 64;
+
+        // gather the chunk from the (up to 9) bytes it touches
+        uint32_t byte = first / 8;
+        uint32_t bit = first % 8;
+        uint32_t bytes = (bit + chunk + 7) / 8;
+
+        uint64_t chunk_tdi = 0;
+        for (uint32_t i = 0; (i < bytes) && (i < 8); i++)
+        {
+            chunk_tdi |= static_cast<uint64_t>(tdi_bits[byte + i]) << (8 * i);
+        }
+        chunk_tdi >>= bit;
+        if (bytes > 8)
+        {
+            chunk_tdi |= static_cast<uint64_t>(tdi_bits[byte + 8]) << (64 - bit);
+        }
+
+        uint64_t chunk_tdo = shift(chunk_tdi, chunk);
+
+        // scatter the result, keeping the bits around the chunk
+        for (uint32_t i = 0; i < bytes; i++)
+        {
+            // offset of byte i relative to bit 0 of the chunk
+            int32_t offset = static_cast<int32_t>(8 * i) - static_cast<int32_t>(bit);
+
+            uint64_t mask = low_bits_mask(chunk);
+            uint64_t byte_tdo;
+            uint64_t byte_mask;
+            if (offset < 0)
+            {
+                byte_tdo = chunk_tdo << -offset;
+                byte_mask = mask << -offset;
+            }
+            else
+            {
+                byte_tdo = chunk_tdo >> offset;
+                byte_mask = mask >> offset;
+            }
+
+            tdo_bits[byte + i] = static_cast<uint8_t>((tdo_bits[byte + i] & ~byte_mask) | (byte_tdo & byte_mask));
+        }
+
+        first += chunk;
+        count -= chunk;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SCAN_CHAIN_H
+#define SCAN_CHAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "scan_register.h"
+
+// The scan registers of all TAPs of a JTAG chain, connected in series between tdi and tdo.
+//
+// Register 0 is next to tdo, the last register is next to tdi, which is the order openocd
+// declares the TAPs in. Bits enter the last register, whatever leaves a register enters the
+// one in front of it.
+//
+// The registers are owned by the TAPs, the chain only points to them.
+class ScanChain
+{
+
+public:
+
+    /// @brief Removes all registers.
+    void clear();
+
+    /// @brief Appends a register at the tdi end of the chain.
+    void append(ScanRegister* scan_register);
+
+    /// @brief The sum of the widths of all registers.
+    uint32_t get_width() const { return width; }
+
+    /// @brief Shifts a single bit through the whole chain.
+    /// @return the bit shifted out at tdo
+    uint8_t shift_bit(uint64_t tdi)
+    {
+        for (size_t i = registers.size(); i-- > 0;)
+        {
+            tdi = registers[i]->shift_bit(tdi);
+        }
+        return static_cast<uint8_t>(tdi);
+    }
+
+    /// @brief Shifts count bits at once. Every register is a pure delay line, so each of them
+    /// shifts the whole chunk before its output is handed on to the next one.
+    /// @param tdi_bits the bits to shift in, bit 0 first
+    /// @param count 1 to 64
+    /// @return the bits shifted out, bit 0 first
+    uint64_t shift(uint64_t tdi_bits, uint32_t count);
+
+    /// @brief Shifts a bit string of any length.
+    /// @param tdi_bits the bits to shift in, bit 0 of byte 0 first
+    /// @param tdo_bits receives the bits shifted out, same layout as tdi_bits. Bits outside of the
+    /// shifted range are left as they are.
+    /// @param first the bit of tdi_bits and tdo_bits to start at
+    /// @param count the amount of bits
+    void shift(const uint8_t* tdi_bits, uint8_t* tdo_bits, uint32_t first, uint32_t count);
+
+private:
+
+    std::vector<ScanRegister*> registers;
+
+    uint32_t width{0};
+
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include "scan_register.h"
+
+static inline uint64_t low_bits_mask(uint32_t count)
+{
+    return (count >= 64) ? ~0ULL : ((1ULL << count) - 1);
+}
+
+/// @brief Reads count (up to 64) bits starting at bit first of a word array.
+static inline uint64_t extract_bits(const uint64_t* words, uint32_t first, uint32_t count)
+{
+    uint32_t word = first / 64;
+    uint32_t bit = first % 64;
+
+    uint64_t bits = words[word] >> bit;
+    if ((bit != 0) && (bit + count > 64))
+    {
+        bits |= words[word + 1] << (64 - bit);
+    }
+    return bits & low_bits_mask(count);
+}
+
+/// @brief ORs count (up to 64) bits into a word array, starting at bit first. The target bits have to be zero.
+static inline void deposit_bits(uint64_t* words, uint32_t first, uint32_t count, uint64_t bits)
+{
+    uint32_t word = first / 64;
+    uint32_t bit = first % 64;
+
+    bits &= low_bits_mask(count);
+    words[word] |= bits << bit;
+    if ((bit != 0) && (bit + count > 64))
+    {
+        words[word + 1] |= bits >> (64 - bit);
+    }
+}
+
+ScanRegister::ScanRegister(uint32_t width) : width(width),
+                                             position(0),
+                                             tdo_bitmap((width + 63) / 64, 0),
+                                             tdi_bitmap((width + 63) / 64, 0)
+{
+    if (width == 0)
+    {
+        fprintf(stderr, "[Error] ScanRegister needs at least one scan cell\n");
+        abort();
+    }
+}
+
+void ScanRegister::capture(uint64_t value)
+{
+    tdo_bitmap[0] = value & low_bits_mask(width);
+    for (size_t i = 1; i < tdo_bitmap.size(); i++)
+    {
+        tdo_bitmap[i] = 0;
+    }
+    clear_tdi_bitmap();
+}
+
+void ScanRegister::capture(const uint64_t* value)
+{
+    for (size_t i = 0; i < tdo_bitmap.size(); i++)
+    {
+        tdo_bitmap[i] = value[i];
+    }
+    tdo_bitmap.back() &= low_bits_mask(width - (tdo_bitmap.size() - 1) * 64);
+    clear_tdi_bitmap();
+}
+
+uint64_t ScanRegister::update()
+{
+    return get_words()[0];
+}
+
+const uint64_t* ScanRegister::get_words()
+{
+    if (position == 0)
+    {
+        return tdo_bitmap.data();
+    }
+
+    // The scan cells hold the captured bits that have not been shifted out yet, followed by
+    // the bits shifted in so far. Make that the new bitmap, so that the shift can continue.
+    std::vector<uint64_t> cells(tdo_bitmap.size(), 0);
+    for (uint32_t done = 0; done < width - position; done += 64)
+    {
+        uint32_t count = std::min<uint32_t>(64, width - position - done);
+        deposit_bits(cells.data(), done, count, extract_bits(tdo_bitmap.data(), position + done, count));
+    }
+    for (uint32_t done = 0; done < position; done += 64)
+    {
+        uint32_t count = std::min<uint32_t>(64, position - done);
+        deposit_bits(cells.data(), width - position + done, count, extract_bits(tdi_bitmap.data(), done, count));
+    }
+
+    tdo_bitmap.swap(cells);
+    clear_tdi_bitmap();
+
+    return tdo_bitmap.data();
+}
+
+uint64_t ScanRegister::shift(uint64_t tdi_bits, uint32_t count)
+{
+    uint64_t tdo_bits = 0;
+    uint32_t done = 0;
+
+    while (done < count)
+    {
+        uint32_t chunk = std::min<uint32_t>(count - done, width - position);
+
+        tdo_bits |= extract_bits(tdo_bitmap.data(), position, chunk) << done;
+        deposit_bits(tdi_bitmap.data(), position, chunk, tdi_bits >> done);
+
+        position += chunk;
+        done += chunk;
+
+        // every captured bit has left the register, the bits shifted in are the next ones to go out
+        if (position == width)
+        {
+            tdo_bitmap.swap(tdi_bitmap);
+            clear_tdi_bitmap();
+        }
+    }
+
+    return tdo_bits;
+}
+
+void ScanRegister::clear_tdi_bitmap()
+{
+    for (size_t i = 0; i < tdi_bitmap.size(); i++)
+    {
+        tdi_bitmap[i] = 0;
+    }
+    position = 0;
+}
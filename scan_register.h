@@ -0,0 +1,82 @@
+#ifndef SCAN_REGISTER_H
+#define SCAN_REGISTER_H
+
+#include <stdint.h>
+#include <vector>
+
+// The shift register (scan cells) of a JTAG register of arbitrary width.
+//
+// Bits are shifted in at the most significant end (from tdi) and out at bit 0 (to tdo).
+// Values are stored in 64 bit words, bit 0 of word 0 is the bit next to tdo.
+//
+// Nothing is actually shifted. The first width bits that leave the register are the captured
+// value, so capture() stores it as the TDO bitmap and a shift only reads the bits at the current
+// position from it and writes the tdi bits at the same position into the TDI bitmap. Once all
+// captured bits are out, the TDI bitmap becomes the next TDO bitmap.
+//
+// capture() and update() are the Capture-xR and Update-xR operations. The value that the
+// register captures from and updates into (the container register) stays with the owner.
+class ScanRegister
+{
+
+public:
+
+    /// @brief constructor
+    /// @param width the amount of scan cells, at least 1
+    explicit ScanRegister(uint32_t width);
+
+    uint32_t get_width() const { return width; }
+
+    /// @brief Capture-xR. Loads the value into the scan cells, bits above the width are dropped.
+    void capture(uint64_t value);
+
+    /// @brief Capture-xR for registers wider than 64 bit.
+    /// @param value (width + 63) / 64 words, bit 0 of word 0 ends up next to tdo
+    void capture(const uint64_t* value);
+
+    /// @brief Update-xR. The content of the scan cells (the lowest 64 bits of it).
+    uint64_t update();
+
+    /// @brief The content of the scan cells, (width + 63) / 64 words.
+    const uint64_t* get_words();
+
+    /// @brief Shifts a single bit.
+    /// @return the bit shifted out
+    uint8_t shift_bit(uint64_t tdi)
+    {
+        uint8_t tdo = (tdo_bitmap[position / 64] >> (position % 64)) & 0x01;
+        tdi_bitmap[position / 64] |= (tdi & 0x01) << (position % 64);
+
+        if (++position == width)
+        {
+            tdo_bitmap.swap(tdi_bitmap);
+            clear_tdi_bitmap();
+        }
+        return tdo;
+    }
+
+    /// @brief Shifts count bits at once. Same result as count single bit shifts.
+    /// @param tdi_bits the bits to shift in, bit 0 first
+    /// @param count 1 to 64
+    /// @return the bits shifted out, bit 0 first
+    uint64_t shift(uint64_t tdi_bits, uint32_t count);
+
+private:
+
+    uint32_t width;
+
+    // amount of bits shifted since the TDO bitmap has been set up
+    uint32_t position;
+
+    // the bits that leave the register next, starting at position
+    std::vector<uint64_t> tdo_bitmap;
+
+    // the bits that have been shifted in, up to position
+    std::vector<uint64_t> tdi_bitmap;
+
+    /// @brief Zeroes the TDI bitmap and starts over at position 0.
+    void clear_tdi_bitmap();
+
+};
+
+#endif
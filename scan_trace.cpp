@@ -0,0 +1,103 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "scan_trace.h"
+
+static_assert(sizeof(scan_trace_header_t) == 32, "the file layout must not change");
+static_assert(sizeof(scan_trace_record_t) == 64, "the file layout must not change");
+
+scan_trace_t::scan_trace_t(const char* path, uint64_t capacity)
+{
+    uint64_t rounded_capacity = 1;
+    while (rounded_capacity < capacity)
+    {
+        rounded_capacity <<= 1;
+    }
+
+    // the records start at a cache line
+    mapping_size = 64 + rounded_capacity * sizeof(scan_trace_record_t);
+
+    void* mapping;
+    if (path == NULL)
+    {
+        mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else
+    {
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1)
+        {
+            fprintf(stderr, "scan_trace failed to open %s: %s (%d)\n", path, strerror(errno), errno);
+            abort();
+        }
+        if (ftruncate(fd, mapping_size) == -1)
+        {
+            fprintf(stderr, "scan_trace failed to size %s: %s (%d)\n", path, strerror(errno), errno);
+            abort();
+        }
+        mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        // the mapping keeps the file open
+        close(fd);
+    }
+
+    if (mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "scan_trace failed to map the ring: %s (%d)\n", strerror(errno), errno);
+        abort();
+    }
+
+    header = static_cast<scan_trace_header_t*>(mapping);
+    records = reinterpret_cast<scan_trace_record_t*>(static_cast<uint8_t*>(mapping) + 64);
+
+    header->magic = SCAN_TRACE_MAGIC;
+    header->record_size = sizeof(scan_trace_record_t);
+    header->capacity = rounded_capacity;
+    header->record_count = 0;
+
+    current = &records[0];
+}
+
+scan_trace_t::~scan_trace_t()
+{
+    munmap(header, mapping_size);
+}
+
+void scan_trace_t::begin(ScanTraceType type)
+{
+    current = &records[header->record_count & (header->capacity - 1)];
+    memset(current, 0, sizeof(scan_trace_record_t));
+    current->type = static_cast<uint8_t>(type);
+}
+
+void scan_trace_t::add_bits(const uint8_t* tdi_bits, const uint8_t* tdo_bits, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        // everything behind the stored bits only adds to the length
+        if (current->length >= SCAN_TRACE_MAX_BITS)
+        {
+            current->length += first + count - i;
+            return;
+        }
+        add_bit((tdi_bits[i / 8] >> (i % 8)) & 0x01, (tdo_bits[i / 8] >> (i % 8)) & 0x01);
+    }
+}
+
+void scan_trace_t::commit(uint8_t instruction)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    current->timestamp_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+    current->instruction = instruction;
+
+    // a reader of the live file sees the record complete before it is counted
+    __atomic_store_n(&header->record_count, header->record_count + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,121 @@
+#ifndef SCAN_TRACE_H
+#define SCAN_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Records every completed IR and DR scan into a ring buffer of fixed size records.
+//
+// The ring lives in a memory mapping, either anonymous or backed by a file. With a file the kernel
+// writes the records back in the background, so recording costs a few stores per shifted bit and
+// the trace survives the process. scan_trace_dump prints a trace file.
+//
+// File layout: a scan_trace_header_t, padded to 64 bytes, followed by capacity scan_trace_record_t.
+// The record of scan n (counting from 0) is stored at index n % capacity.
+
+#define SCAN_TRACE_MAGIC 0x314352544E414353ULL // "SCANTRC1"
+
+// bits of a scan that are stored, longer scans are recorded with their full length but truncated bits
+#define SCAN_TRACE_MAX_BITS 192
+
+enum class ScanTraceType : uint8_t {
+    IR_SCAN = 0,
+    DR_SCAN = 1
+};
+
+struct scan_trace_header_t
+{
+    uint64_t magic;
+
+    uint32_t record_size;
+
+    uint32_t reserved;
+
+    // amount of records the ring holds, a power of two
+    uint64_t capacity;
+
+    // amount of scans recorded so far, the ring holds the last capacity of them
+    uint64_t record_count;
+};
+
+// 64 bytes, a cache line
+struct scan_trace_record_t
+{
+    // CLOCK_REALTIME in nanoseconds at Update-IR / Update-DR
+    uint64_t timestamp_ns;
+
+    // amount of bits shifted
+    uint32_t length;
+
+    // ScanTraceType
+    uint8_t type;
+
+    // the DTM instruction the DR scan went to, the instruction an IR scan loaded
+    uint8_t instruction;
+
+    uint16_t reserved;
+
+    // bit 0 of byte 0 is the first bit shifted
+    uint8_t bits_in[SCAN_TRACE_MAX_BITS / 8];
+    uint8_t bits_out[SCAN_TRACE_MAX_BITS / 8];
+};
+
+class scan_trace_t
+{
+
+public:
+
+    /// @brief Constructor. Aborts if the trace cannot be created.
+    /// @param path the file to record into, it is created or truncated. NULL records into memory only.
+    /// @param capacity amount of records the ring holds, rounded up to a power of two
+    scan_trace_t(const char* path, uint64_t capacity);
+
+    ~scan_trace_t();
+
+    /// @brief Capture-IR / Capture-DR. Starts a new record.
+    void begin(ScanTraceType type);
+
+    /// @brief Records a single shifted bit.
+    void add_bit(uint64_t tdi, uint8_t tdo)
+    {
+        uint32_t length = current->length++;
+        if (length < SCAN_TRACE_MAX_BITS)
+        {
+            current->bits_in[length / 8] |= (tdi & 0x01) << (length % 8);
+            current->bits_out[length / 8] |= (tdo & 0x01) << (length % 8);
+        }
+    }
+
+    /// @brief Records a run of shifted bits.
+    /// @param tdi_bits the bits shifted in, bit 0 of byte 0 first
+    /// @param tdo_bits the bits shifted out, same layout
+    /// @param first the bit of tdi_bits and tdo_bits to start at
+    /// @param count the amount of bits
+    void add_bits(const uint8_t* tdi_bits, const uint8_t* tdo_bits, uint32_t first, uint32_t count);
+
+    /// @brief Update-IR / Update-DR. Completes the record started by begin().
+    /// @param instruction the DTM instruction (see scan_trace_record_t)
+    void commit(uint8_t instruction);
+
+    /// @brief amount of scans recorded so far
+    uint64_t get_record_count() const { return header->record_count; }
+
+    uint64_t get_capacity() const { return header->capacity; }
+
+    /// @brief The record of scan n. Only the last get_capacity() scans are available.
+    const scan_trace_record_t& get_record(uint64_t n) const { return records[n & (header->capacity - 1)]; }
+
+private:
+
+    scan_trace_header_t* header;
+
+    scan_trace_record_t* records;
+
+    size_t mapping_size;
+
+    // the record begin() has started, always the slot behind the last committed one
+    scan_trace_record_t* current;
+
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "scan_trace.h"
+
+// Prints the scans recorded into a trace file (see --trace), oldest first.
+//
+// Usage: scan_trace_dump.out <trace file>
+
+/// @brief Prints the first length bits as a hex number, the first bit shifted is the least significant one.
+static void print_bits(const uint8_t* bits, uint32_t length)
+{
+    if (length > SCAN_TRACE_MAX_BITS)
+    {
+        length = SCAN_TRACE_MAX_BITS;
+    }
+
+    printf("0x");
+    for (int32_t nibble = (static_cast<int32_t>(length) + 3) / 4 - 1; nibble >= 0; nibble--)
+    {
+        uint32_t value = (bits[nibble / 2] >> ((nibble % 2) * 4)) & 0x0F;
+
+        // the top nibble only holds the remaining bits
+        uint32_t valid = length - nibble * 4;
+        if (valid < 4)
+        {
+            value &= (1 << valid) - 1;
+        }
+        printf("%x", value);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+        return -1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "[Error] cannot open %s\n", argv[1]);
+        return -1;
+    }
+
+    scan_trace_header_t header;
+    if ((fread(&header, sizeof(header), 1, file) != 1) || (header.magic != SCAN_TRACE_MAGIC) ||
+        (header.record_size != sizeof(scan_trace_record_t)))
+    {
+        fprintf(stderr, "[Error] %s is not a scan trace\n", argv[1]);
+        fclose(file);
+        return -1;
+    }
+
+    std::vector<scan_trace_record_t> records(header.capacity);
+    if ((fseek(file, 64, SEEK_SET) != 0) ||
+        (fread(records.data(), sizeof(scan_trace_record_t), header.capacity, file) != header.capacity))
+    {
+        fprintf(stderr, "[Error] %s is truncated\n", argv[1]);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    uint64_t first = (header.record_count > header.capacity) ? (header.record_count - header.capacity) : 0;
+    printf("# %llu scans recorded, the last %llu are available\n",
+        static_cast<unsigned long long>(header.record_count),
+        static_cast<unsigned long long>(header.record_count - first));
+
+    for (uint64_t n = first; n < header.record_count; n++)
+    {
+        const scan_trace_record_t& record = records[n & (header.capacity - 1)];
+
+        printf("%llu %llu.%09llu %s ir=0x%02x len=%u in=",
+            static_cast<unsigned long long>(n),
+            static_cast<unsigned long long>(record.timestamp_ns / 1000000000ULL),
+            static_cast<unsigned long long>(record.timestamp_ns % 1000000000ULL),
+            (record.type == static_cast<uint8_t>(ScanTraceType::IR_SCAN)) ? "IR" : "DR",
+            record.instruction, record.length);
+        print_bits(record.bits_in, record.length);
+        printf(" out=");
+        print_bits(record.bits_out, record.length);
+        printf("\n");
+    }
+
+    return 0;
+}
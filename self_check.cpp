@@ -0,0 +1,186 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "bitbang_decoder.h"
+#include "tap_state_machine.h"
+
+// Checks the lookup tables and the decoder the fast paths are built on against the plain code they replace.
+//
+// Every check compares the whole input space (or a large random sample of it) and prints the
+// first difference it finds. The program returns 0 if all checks pass.
+
+// remembers every callback of the state machine
+class recording_handler_t
+{
+
+public:
+
+    std::vector<uint8_t> entered;
+
+    void state_entered(tsm_state new_state, uint8_t rising_edge_clk)
+    {
+        entered.push_back(static_cast<uint8_t>((new_state << 1) | (rising_edge_clk & 0x01)));
+    }
+
+};
+
+/// @brief Clocks every combination of start state and 8 TMS bits through transition_8() and through
+/// 8 single transition() calls and compares the states and the callbacks. Also checks the
+/// tsm_multi_step_table entries against the states the single steps have entered.
+/// @return the amount of differences
+static uint32_t check_tap_state_machine()
+{
+    // no callbacks (the table lookup), every state, and every single state on its own
+    std::vector<uint32_t> masks = { 0, TSM_ALL_STATES };
+    for (uint32_t state = 0; state < 16; state++)
+    {
+        masks.push_back(tsm_state_bit(static_cast<tsm_state>(state)));
+    }
+
+    uint32_t errors = 0;
+    for (uint32_t start = 0; start < 16; start++)
+    {
+        for (uint32_t tms_bits = 0; tms_bits < 256; tms_bits++)
+        {
+            const tsm_multi_step_t& step = tsm_multi_step_table.steps[start][tms_bits];
+
+            for (uint32_t mask : masks)
+            {
+                recording_handler_t single_handler;
+                TSMStateMachine<recording_handler_t> single(&single_handler);
+                single.set_interested_states(mask);
+                single.tsm_current_state = static_cast<tsm_state>(start);
+
+                recording_handler_t multi_handler;
+                TSMStateMachine<recording_handler_t> multi(&multi_handler);
+                multi.set_interested_states(mask);
+                multi.tsm_current_state = static_cast<tsm_state>(start);
+
+                uint16_t visited = 0;
+                uint16_t self_loops = 0;
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    tsm_state previous_state = single.tsm_current_state;
+                    single.transition((tms_bits >> i) & 0x01, 1);
+                    visited |= tsm_state_bit(single.tsm_current_state);
+                    if (single.tsm_current_state == previous_state)
+                    {
+                        self_loops |= tsm_state_bit(previous_state);
+                    }
+                }
+                multi.transition_8(static_cast<uint8_t>(tms_bits));
+
+                if ((single.tsm_current_state != multi.tsm_current_state) || (single_handler.entered != multi_handler.entered) ||
+                    (step.final_state != single.tsm_current_state) || (step.visited != visited) || (step.self_loops != self_loops))
+                {
+                    if (errors == 0)
+                    {
+                        fprintf(stderr, "[Error] transition_8() differs from transition() for start state %u, TMS 0x%02x, mask 0x%04x\n",
+                            start, tms_bits, mask);
+                    }
+                    errors++;
+                }
+            }
+        }
+    }
+
+    printf("TAP state machine: %u start states x 256 TMS values x %zu callback masks, %u differences\n",
+        16, masks.size(), errors);
+
+    return errors;
+}
+
+/// @brief Decodes a block one command at a time, the way execute_single_command() sees the commands.
+static void decode_reference(const char* commands, size_t count, bitbang_block_t& block)
+{
+    block = { 0, 0, 0, 0, 0 };
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char command = commands[i];
+        if ((command < '0') || (command > '7'))
+        {
+            block.others |= 1ULL << i;
+            continue;
+        }
+
+        uint64_t value = command - '0';
+        block.pins |= 1ULL << i;
+        block.tck |= ((value >> 2) & 0x01) << i;
+        block.tms |= ((value >> 1) & 0x01) << i;
+        block.tdi |= (value & 0x01) << i;
+    }
+}
+
+/// @brief Compares bitbang_decode() with decode_reference() for every command byte at every position
+/// and for random blocks of every length and alignment.
+/// @return the amount of differences
+static uint32_t check_decoder()
+{
+    const uint32_t random_blocks = 200000;
+
+    // one spare byte in front for the unaligned blocks
+    char buffer[65];
+    uint32_t blocks = 0;
+    uint32_t errors = 0;
+
+    std::mt19937 random(1);
+
+    for (uint32_t i = 0; i < 256 * 64 + random_blocks; i++)
+    {
+        char* commands = buffer;
+        size_t count = 64;
+
+        if (i < 256 * 64)
+        {
+            // a single byte value at a single position between pin commands
+            memset(buffer, '5', sizeof(buffer));
+            commands[i / 256] = static_cast<char>(i % 256);
+        }
+        else
+        {
+            // mostly pin commands, the commands openocd sends in between and arbitrary bytes
+            static const char commands_of_openocd[] = "01234567RrstuBbQ";
+            for (size_t j = 0; j < sizeof(buffer); j++)
+            {
+                uint32_t pick = random() % 32;
+                buffer[j] = (pick < 16) ? commands_of_openocd[pick] : static_cast<char>(random() % 256);
+            }
+            commands = buffer + (random() % 2);
+            count = random() % 65;
+        }
+
+        bitbang_block_t block;
+        bitbang_block_t reference;
+        bitbang_decode(commands, count, block);
+        decode_reference(commands, count, reference);
+        blocks++;
+
+        if ((block.pins != reference.pins) || (block.others != reference.others) ||
+            (block.tck != reference.tck) || (block.tms != reference.tms) || (block.tdi != reference.tdi))
+        {
+            if (errors == 0)
+            {
+                fprintf(stderr, "[Error] bitbang_decode() (%s) differs from the reference for block %u, %zu commands\n",
+                    bitbang_decoder_name(), i, count);
+            }
+            errors++;
+        }
+    }
+
+    printf("bitbang decoder (%s): %u blocks, %u differences\n", bitbang_decoder_name(), blocks, errors);
+
+    return errors;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t errors = 0;
+
+    errors += check_tap_state_machine();
+    errors += check_decoder();
+
+    return (errors == 0) ? 0 : 1;
+}
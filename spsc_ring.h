@@ -0,0 +1,86 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+// Lock-free ring buffer for exactly one producer thread and exactly one consumer thread.
+//
+// head is only written by the consumer, tail only by the producer. Both count up forever and are
+// masked on access, which is why Capacity has to be a power of two. Each side keeps a cached copy
+// of the other side's index and only reloads it (which costs a cache line transfer) when the
+// cached value says the ring is full or empty.
+template <typename T, size_t Capacity>
+class spsc_ring_t
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "elements are copied with memcpy()");
+
+public:
+
+    /// @brief Appends as many elements as there is space for. Called by the producer only.
+    /// @param data the elements to append
+    /// @param count the amount of elements
+    /// @return the amount of elements that have been appended
+    size_t push(const T* data, size_t count)
+    {
+        size_t tail_value = tail.load(std::memory_order_relaxed);
+
+        if (Capacity - (tail_value - producer_head) < count)
+        {
+            producer_head = head.load(std::memory_order_acquire);
+        }
+        count = std::min(count, Capacity - (tail_value - producer_head));
+
+        size_t offset = tail_value & (Capacity - 1);
+        size_t first = std::min(count, Capacity - offset);
+        memcpy(&buffer[offset], data, first * sizeof(T));
+        memcpy(&buffer[0], data + first, (count - first) * sizeof(T));
+
+        tail.store(tail_value + count, std::memory_order_release);
+
+        return count;
+    }
+
+    /// @brief Removes up to count elements. Called by the consumer only.
+    /// @param data receives the elements
+    /// @param count the maximum amount of elements to remove
+    /// @return the amount of elements that have been removed
+    size_t pop(T* data, size_t count)
+    {
+        size_t head_value = head.load(std::memory_order_relaxed);
+
+        if ((consumer_tail - head_value) < count)
+        {
+            consumer_tail = tail.load(std::memory_order_acquire);
+        }
+        count = std::min(count, consumer_tail - head_value);
+
+        size_t offset = head_value & (Capacity - 1);
+        size_t first = std::min(count, Capacity - offset);
+        memcpy(data, &buffer[offset], first * sizeof(T));
+        memcpy(data + first, &buffer[0], (count - first) * sizeof(T));
+
+        head.store(head_value + count, std::memory_order_release);
+
+        return count;
+    }
+
+private:
+
+    // consumer side
+    alignas(64) std::atomic<size_t> head{0};
+    size_t consumer_tail{0};
+
+    // producer side
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t producer_head{0};
+
+    alignas(64) T buffer[Capacity];
+
+};
+
+#endif
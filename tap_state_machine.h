@@ -53,24 +53,168 @@
 
 
 
+// Next state for every state and TMS value, indexed [state][tms]. Same order as enum tsm_state.
+constexpr tsm_state tsm_next_state_table[16][2] = {
+    { RUN_TEST_IDLE, TEST_LOGIC_RESET }, // TEST_LOGIC_RESET
+    { RUN_TEST_IDLE, SELECT_DR_SCAN },   // RUN_TEST_IDLE
+    { CAPTURE_DR, SELECT_IR_SCAN },      // SELECT_DR_SCAN
+    { CAPTURE_IR, TEST_LOGIC_RESET },    // SELECT_IR_SCAN
+    { SHIFT_DR, EXIT1_DR },              // CAPTURE_DR
+    { SHIFT_IR, EXIT1_IR },              // CAPTURE_IR
+    { SHIFT_DR, EXIT1_DR },              // SHIFT_DR
+    { SHIFT_IR, EXIT1_IR },              // SHIFT_IR
+    { PAUSE_DR, UPDATE_DR },             // EXIT1_DR
+    { PAUSE_IR, UPDATE_IR },             // EXIT1_IR
+    { PAUSE_DR, EXIT2_DR },              // PAUSE_DR
+    { PAUSE_IR, EXIT2_IR },              // PAUSE_IR
+    { SHIFT_DR, UPDATE_DR },             // EXIT2_DR
+    { SHIFT_IR, UPDATE_IR },             // EXIT2_IR
+    { RUN_TEST_IDLE, SELECT_DR_SCAN },   // UPDATE_DR
+    { RUN_TEST_IDLE, SELECT_DR_SCAN }    // UPDATE_IR
+};
+
+/// @brief bit of a state inside a state mask (see TSMStateMachine::set_interested_states())
+constexpr uint32_t tsm_state_bit(tsm_state state)
+{
+    return 1u << state;
+}
+
+constexpr uint32_t TSM_ALL_STATES = 0xFFFF;
+
+// Result of clocking 8 TMS bits (LSB first) into the state machine at once.
+struct tsm_multi_step_t {
+
+    // the state after the 8th rising edge
+    uint8_t final_state;
+
+    // bit mask (tsm_state_bit()) of all states entered on the way, including final_state
+    uint16_t visited;
+
+    // bit mask (tsm_state_bit()) of the states that have looped back onto themselves on the way
+    uint16_t self_loops;
+
+};
+
+struct tsm_multi_step_table_t {
+
+    // indexed [start state][8 TMS bits]
+    tsm_multi_step_t steps[16][256];
+
+    constexpr tsm_multi_step_table_t() : steps() {
+
+        for (int start = 0; start < 16; start++) {
+            for (int tms_bits = 0; tms_bits < 256; tms_bits++) {
+
+                int state = start;
+                uint16_t visited = 0;
+                uint16_t self_loops = 0;
+                for (int i = 0; i < 8; i++) {
+                    int next_state = tsm_next_state_table[state][(tms_bits >> i) & 0x01];
+                    if (next_state == state) {
+                        self_loops |= 1u << state;
+                    }
+                    state = next_state;
+                    visited |= 1u << state;
+                }
+
+                steps[start][tms_bits].final_state = state;
+                steps[start][tms_bits].visited = visited;
+                steps[start][tms_bits].self_loops = self_loops;
+            }
+        }
+    }
+
+};
+
+constexpr tsm_multi_step_table_t tsm_multi_step_table;
+
+// The state machine calls Handler::state_entered() whenever it enters a state the handler is interested in.
+//
+// The handler type is fixed at compile time, so the call is bound statically and can be inlined into
+// the transition code (declare the handler's state_entered() final to allow this for virtual methods).
+// TSMStateMachine<> dispatches through the virtual TSMStateMachineCallback interface for users that
+// have to pick their handler at runtime.
+template <class Handler = TSMStateMachineCallback>
 class TSMStateMachine {
 
     private:
 
-        TSMStateMachineCallback* p_tsm_state_machine_callback;
+        Handler* p_tsm_state_machine_callback;
+
+        // states that the callback wants to hear about
+        uint32_t interested_mask{TSM_ALL_STATES};
 
     public:
 
         tsm_state tsm_current_state;
 
-        TSMStateMachine(TSMStateMachineCallback* p_tsm_state_machine_callback);
-
-        void tsm_reset();
-
-        void tsm_force_into_state(tsm_state new_state);
-
-        void transition(uint8_t input, uint8_t rising_edge_clk);
+        // a TAP powers up in Test-Logic-Reset
+        TSMStateMachine(Handler* p_tsm_state_machine_callback_in)
+            : p_tsm_state_machine_callback(p_tsm_state_machine_callback_in),
+              tsm_current_state(TEST_LOGIC_RESET)
+        {
+            // empty
+        }
+
+        void tsm_reset()
+        {
+            tsm_force_into_state(TEST_LOGIC_RESET);
+        }
+
+        void tsm_force_into_state(tsm_state new_state)
+        {
+            fprintf(stderr, "TSM tsm_force_into_state()\n");
+            tsm_current_state = new_state;
+
+            if (interested_mask & tsm_state_bit(tsm_current_state)) {
+                p_tsm_state_machine_callback->state_entered(tsm_current_state, 1);
+            }
+        }
+
+        /// @brief Only entering one of these states calls the callback. Entering any other state
+        /// merely updates tsm_current_state. The default are all states.
+        /// @param mask bit mask built from tsm_state_bit()
+        void set_interested_states(uint32_t mask) { interested_mask = mask; }
+
+        uint32_t get_interested_states() { return interested_mask; }
+
+        /// @brief Clocks a single TMS value into the state machine (see the diagram above).
+        /// @param input TMS
+        /// @param rising_edge_clk the state machine only transitions on the rising edge
+        void transition(uint8_t input, uint8_t rising_edge_clk)
+        {
+            // on the rising edge, the TAP state machine transitions.
+            // On the falling edge, the state machine remains in the current state
+            if (rising_edge_clk != 0) {
+                tsm_current_state = tsm_next_state_table[tsm_current_state][input & 0x01];
+            }
+
+            if (interested_mask & tsm_state_bit(tsm_current_state)) {
+                p_tsm_state_machine_callback->state_entered(tsm_current_state, rising_edge_clk);
+            }
+        }
+
+        /// @brief Clocks 8 TMS bits at once (8 rising edges). Resolves the whole sequence with a
+        /// single table lookup unless it enters a state the callback is interested in.
+        /// @param tms_bits TMS values, bit 0 is clocked in first
+        void transition_8(uint8_t tms_bits)
+        {
+            const tsm_multi_step_t& step = tsm_multi_step_table.steps[tsm_current_state][tms_bits];
+
+            // no callbacks on the way, jump right to the end
+            if ((step.visited & interested_mask) == 0) {
+                tsm_current_state = static_cast<tsm_state>(step.final_state);
+                return;
+            }
+
+            for (int i = 0; i < 8; i++) {
+                transition((tms_bits >> i) & 0x01, 1);
+            }
+        }
 
 };
 
+// the runtime dispatched version is compiled once inside tap_state_machine.cpp
+extern template class TSMStateMachine<TSMStateMachineCallback>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "tap_state_machine.h"
+
+// Measures how many clock edges per second the TAP state machine processes.
+//
+// The handler does the same amount of work as remote_bitbang_t does for the states it is interested in,
+// which is close to nothing, so the numbers show the cost of the state machine and of the dispatch.
+
+// handler that is bound at compile time
+class bench_handler_t
+{
+
+public:
+
+    uint64_t captures{0};
+    uint64_t updates{0};
+
+    void state_entered(tsm_state new_state, uint8_t rising_edge_clk)
+    {
+        switch (new_state)
+        {
+        case CAPTURE_DR:
+        case CAPTURE_IR:
+            captures++;
+            break;
+        case UPDATE_DR:
+        case UPDATE_IR:
+            updates++;
+            break;
+        default:
+            break;
+        }
+    }
+
+};
+
+// the same handler behind the virtual interface
+class bench_callback_t : public TSMStateMachineCallback
+{
+
+public:
+
+    bench_handler_t handler;
+
+    virtual void state_entered(tsm_state new_state, uint8_t rising_edge_clk) override
+    {
+        handler.state_entered(new_state, rising_edge_clk);
+    }
+
+};
+
+/// @brief The TMS values openocd sends for a single DMI access: IR scan, 41 bit DR scan, run-test/idle.
+static std::vector<uint8_t> dmi_access_tms()
+{
+    std::vector<uint8_t> tms;
+
+    // Run-Test/Idle -> Shift-IR, 5 bit IR, -> Update-IR -> Run-Test/Idle
+    for (uint8_t bit : { 1, 1, 0, 0 }) tms.push_back(bit);
+    for (int i = 0; i < 4; i++) tms.push_back(0);
+    for (uint8_t bit : { 1, 1, 0 }) tms.push_back(bit);
+
+    // Run-Test/Idle -> Shift-DR, 41 bit DR, -> Update-DR -> Run-Test/Idle
+    for (uint8_t bit : { 1, 0, 0 }) tms.push_back(bit);
+    for (int i = 0; i < 40; i++) tms.push_back(0);
+    for (uint8_t bit : { 1, 1, 0 }) tms.push_back(bit);
+
+    // idle cycles
+    for (int i = 0; i < 5; i++) tms.push_back(0);
+
+    return tms;
+}
+
+template <class Handler>
+static double edges_per_second(TSMStateMachine<Handler>& tsm_state_machine, const std::vector<uint8_t>& tms, uint32_t repetitions)
+{
+    uint32_t interested = tsm_state_bit(TEST_LOGIC_RESET) |
+        tsm_state_bit(CAPTURE_DR) | tsm_state_bit(CAPTURE_IR) |
+        tsm_state_bit(UPDATE_DR) | tsm_state_bit(UPDATE_IR);
+
+    tsm_state_machine.set_interested_states(interested);
+    tsm_state_machine.tsm_current_state = RUN_TEST_IDLE;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < repetitions; i++)
+    {
+        for (uint8_t bit : tms)
+        {
+            tsm_state_machine.transition(bit, 1);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return (static_cast<double>(tms.size()) * repetitions) / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t repetitions = 2000000;
+    std::vector<uint8_t> tms = dmi_access_tms();
+
+    bench_callback_t callback;
+    TSMStateMachine<> dynamic_tsm_state_machine(&callback);
+    double dynamic_rate = edges_per_second(dynamic_tsm_state_machine, tms, repetitions);
+
+    bench_handler_t handler;
+    TSMStateMachine<bench_handler_t> static_tsm_state_machine(&handler);
+    double static_rate = edges_per_second(static_tsm_state_machine, tms, repetitions);
+
+    if ((callback.handler.captures != handler.captures) || (callback.handler.updates != handler.updates))
+    {
+        fprintf(stderr, "[Error] dispatch variants disagree\n");
+        return -1;
+    }
+
+    printf("TSMStateMachine<> (virtual callback):   %8.1f M edges/s\n", dynamic_rate / 1e6);
+    printf("TSMStateMachine<Handler> (static):      %8.1f M edges/s\n", static_rate / 1e6);
+
+    return 0;
+}